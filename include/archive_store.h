@@ -0,0 +1,20 @@
+#ifndef ARCHIVE_STORE_H
+#define ARCHIVE_STORE_H
+
+#include "ts_codec.h"
+
+// ===== Archive compressée long terme =====
+// /archive.bin : blocs scellés de TS_BLOCK_SIZE octets, bout à bout
+// /archive.open : journal du bloc en cours, une ligne CSV avec CRC (csv_record.h) par échantillon,
+//                 en ajout seul ; rejoué dans l'encodeur au démarrage, vidé au scellement
+// Extraction hors ligne seulement (tools/compost_dump, dump de la flash) : le firmware ne relit
+// que /data.csv, qui reste le journal de référence. L'archive ne prolonge pas la rétention
+// sur l'appareil ; elle ajoute ~10 octets de flash par échantillon (ligne CSV : ~58).
+
+static const char ARCHIVE_FILE[] = "/archive.bin";
+static const char ARCHIVE_OPEN_FILE[] = "/archive.open";
+
+void archiveStoreBegin();                  // Récupération + import initial du CSV si archive absente
+void archiveStorePush(const Sample3 &s);
+
+#endif
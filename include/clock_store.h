@@ -0,0 +1,19 @@
+#ifndef CLOCK_STORE_H
+#define CLOCK_STORE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "epoch_table.h"
+
+// ===== Segments d'horloge persistés =====
+// Table en mémoire RTC (survit au deep sleep) recopiée en NVS à chaque changement (survit aux
+// coupures), et dans EPOCH_FILE pour les dumps SPIFFS (tools/compost_dump). Les échantillons sont enregistrés en temps brut (time()) ; l'heure réelle est
+// calculée à la lecture (epoch_table.h).
+
+void clockBegin();                      // setup(), après storageBegin : horloge jamais en arrière
+bool clockSync(time_t realNow);         // Heure client : false si écart négligeable (table inchangée)
+void clockEpochs(EpochTable &out);      // Copie figée pour une requête
+uint32_t clockReal(time_t raw);         // Temps brut -> heure réelle
+int32_t clockOffset(time_t raw);
+
+#endif
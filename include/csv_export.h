@@ -0,0 +1,35 @@
+#ifndef CSV_EXPORT_H
+#define CSV_EXPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "csv_log.h"
+#include "epoch_table.h"
+#include "date_format.h"
+
+// ===== Export CSV en flux (/csv/data) =====
+// Relit /data.csv par blocs et formate les lignes directement dans le tampon de réponse :
+// la mémoire ne dépend pas de la taille du journal.
+
+static const char CSV_EXPORT_HEADER[] =
+  "date_time,temperature_bac1,humidity_bac1,oxygen_bac1,temperature_bac2,humidity_bac2,temperature_bac3,humidity_bac3\n";
+
+struct CsvExport {
+  CsvLogReader reader;
+  EpochTable epochs;        // Segments d'horloge appliqués aux timestamps (figés à la requête)
+  uint32_t from = 0;        // Filtre sur le temps exporté (epoch)
+  uint32_t to = 0xFFFFFFFF;
+  bool started = false;     // En-tête émis
+  bool done = false;        // Fin du journal atteinte
+  char pending[512];        // Lignes formatées pas encore envoyées
+  size_t pendLen = 0;
+  size_t pendOff = 0;
+  DateCache date;           // Jour local courant (localtime une fois par jour, pas par ligne)
+};
+
+void csvExportBegin(CsvExport &e, const EpochTable &epochs, uint32_t from, uint32_t to);
+// 0 = fin ; CSV_SCAN_AGAIN = budget de lignes épuisé sans rien à envoyer (rappeler plus tard)
+size_t csvExportFill(CsvExport &e, uint8_t *buf, size_t maxLen);
+
+#endif
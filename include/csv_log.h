@@ -0,0 +1,50 @@
+#ifndef CSV_LOG_H
+#define CSV_LOG_H
+
+#include <functional>
+#include <FS.h>
+#include "csv_record.h"
+
+// ===== Journal CSV en flash (/data.csv) =====
+// Les lignes s'accumulent dans un lot en RAM ; le lot part en flash d'un seul bloc dès qu'il
+// complète la page de données SPIFFS courante (CSV_PAGE_DATA octets de fichier par page), le reste
+// attend la page suivante. Double tampon : pendant l'écriture d'un lot, les lecteurs copient
+// sous verrou le lot en vol + le lot courant, sans jamais attendre la flash.
+// Un seul écrivain (csvLogAppend / csvLogFlush) : tâche flash du pipeline ou loop().
+// Firmware seulement (File SPIFFS) ; nom et constantes du journal : csv_record.h.
+
+// Flux HTTP relisant le journal (export, requête) : lignes lues au plus par appel, pour que la
+// tâche AsyncTCP rende la main même quand le filtre écarte presque tout le journal
+static const size_t CSV_SCAN_ROWS_MAX = 512;
+static const size_t CSV_SCAN_AGAIN = (size_t)-1;  // Budget épuisé, rien à envoyer : RESPONSE_TRY_AGAIN
+
+void csvLogBegin();                      // En-tête si absent + récupération de la fin de fichier
+bool csvLogAppend(const Sample3 &s);     // Ligne ajoutée au lot ; false si formatage ou écriture en échec
+bool csvLogFlush();                      // Lot en attente -> flash (arrêt WiFi, avant deep sleep)
+time_t csvLogLastTime();                 // Temps de la dernière ligne valide en flash, 0 si aucune
+size_t csvLogForEach(const std::function<void(const Sample3 &)> &cb);  // Lignes valides uniquement
+
+// Lecture séquentielle reprenable (export HTTP découpé) : le fichier reste ouvert entre deux appels.
+// open() fige la vue : octets déjà en flash, puis copie des lots encore en RAM.
+class CsvLogReader {
+ public:
+  bool open();
+  bool next(Sample3 &s);  // Prochaine ligne valide ; false en fin de fichier
+  void close();
+
+ private:
+  File f;
+  size_t fileLimit = 0;  // Octets du fichier à lire (les lots écrits après open() sont dans pending)
+  size_t fileRead = 0;
+  char pending[2 * CSV_BATCH_MAX];
+  size_t pendingLen = 0;
+  size_t pendingPos = 0;
+  uint8_t chunk[256];
+  size_t chunkLen = 0;
+  size_t chunkPos = 0;
+  char line[CSV_RECORD_MAX];
+  size_t lineLen = 0;
+  bool overflow = false;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef CSV_QUERY_H
+#define CSV_QUERY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+#include "csv_log.h"
+#include "epoch_table.h"
+#include "date_format.h"
+
+// ===== Agrégation par créneaux en flux (/api/query) =====
+// Une seule passe sur /data.csv : un créneau ouvert à la fois, émis dès que le journal passe
+// au suivant. Mémoire constante quelle que soit la période demandée.
+//
+// Réponse : {"field":"b1Temp","agg":"avg","bucket":3600,"data":[[t,v],...]}
+// t = début du créneau (temps exporté), v = null si aucune valeur retenue. Créneaux d'un nombre
+// entier de jours alignés sur minuit local (TZ : 1d = jour civil, 23 h ou 25 h aux changements
+// d'heure), les autres sur l'epoch.
+// Seuls les créneaux contenant au moins une ligne apparaissent.
+
+enum QueryAgg { QUERY_AVG, QUERY_MIN, QUERY_MAX, QUERY_COUNT };
+
+static const uint32_t QUERY_BUCKET_MIN = 60;  // 1 min
+
+struct CsvQuery {
+  CsvLogReader reader;
+  int ch = 0;               // Canal Sample3 (ordre CSV)
+  QueryAgg agg = QUERY_AVG;
+  uint32_t bucket = 3600;   // Largeur de créneau (s)
+  EpochTable epochs;        // Segments d'horloge (figés à la requête)
+  uint32_t from = 0;        // Filtre sur le temps exporté (epoch)
+  uint32_t to = 0xFFFFFFFF;
+  float gt = -INFINITY;     // Valeurs retenues : gt < v < lt (ex. count au-dessus de 55 °C)
+  float lt = INFINITY;
+
+  // Créneau ouvert
+  bool open = false;
+  uint32_t start = 0;
+  int32_t startDay = 0;     // Créneaux en jours : premier jour local du créneau ouvert
+  DateCache date;           // Jour local des lignes (localtime une fois par jour)
+  double sum = 0;
+  float min = 0, max = 0;
+  uint32_t n = 0;
+
+  uint32_t rows = 0;        // Créneaux émis (placement des virgules)
+  bool started = false;     // En-tête émis
+  bool done = false;        // Fin du journal atteinte
+  bool closed = false;      // Pied émis
+  char pending[512];
+  size_t pendLen = 0;
+  size_t pendOff = 0;
+};
+
+// Paramètres de requête ; false si invalides
+bool csvQueryField(const char *name, int &ch);        // "b1Temp" ... "b3Hum"
+bool csvQueryAgg(const char *name, QueryAgg &agg);    // "avg" | "min" | "max" | "count"
+bool csvQueryBucket(const char *spec, uint32_t &sec); // "900", "15m", "1h", "1d" (>= 1 min)
+bool csvQueryValue(const char *spec, float &v);       // Seuil gt / lt : nombre décimal fini
+
+void csvQueryBegin(CsvQuery &q, const EpochTable &epochs, uint32_t from, uint32_t to);
+// 0 = fin ; CSV_SCAN_AGAIN = budget de lignes épuisé sans rien à envoyer (rappeler plus tard)
+size_t csvQueryFill(CsvQuery &q, uint8_t *buf, size_t maxLen);
+
+#endif
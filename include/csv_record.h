@@ -0,0 +1,34 @@
+#ifndef CSV_RECORD_H
+#define CSV_RECORD_H
+
+#include <stddef.h>
+#include "web_app.h"
+
+// ===== Enregistrement CSV avec somme de contrôle =====
+// Ligne : "<epoch>,<b1Temp>,<b1Hum>,<b1O2>,<b2Temp>,<b2Hum>,<b3Temp>,<b3Hum>*<CRC16 hex>\n"
+// Le CRC suivi du '\n' sert de marqueur de validation : une ligne sans l'un ou l'autre est déchirée.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+static const size_t CSV_RECORD_MAX = 112;  // Taille max d'une ligne formatée, '\n' inclus
+
+static const char CSV_HEADER[] =
+  "timestamp,temperature_bac1,humidity_bac1,oxygen_bac1,temperature_bac2,humidity_bac2,temperature_bac3,humidity_bac3";
+
+// ---------- Journal /data.csv ----------
+static const char CSV_LOG_FILE[] = "/data.csv";
+// Octets de fichier par page de données SPIFFS : page logique de 256 (défaut ESP32) moins
+// l'en-tête spiffs_page_header (obj_id 2 + span_ix 2 + flags 1)
+static const size_t CSV_PAGE_DATA = 256 - 5;
+static const size_t CSV_BATCH_MAX = CSV_PAGE_DATA + CSV_RECORD_MAX;  // Lot : page + une ligne qui déborde
+
+enum CsvRecordStatus {
+  CSV_RECORD_OK,       // Ligne avec CRC valide
+  CSV_RECORD_LEGACY,   // Ancienne ligne sans CRC (timestamp ou date/heure)
+  CSV_RECORD_HEADER,   // Ligne d'en-tête
+  CSV_RECORD_BAD       // CRC faux ou ligne illisible
+};
+
+size_t csvFormatRecord(const Sample3 &s, char *out, size_t cap);  // Retourne la longueur ('\n' inclus), 0 si trop petit
+CsvRecordStatus csvParseRecord(const char *line, size_t len, Sample3 &s);  // line sans '\n'
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef DATE_FORMAT_H
+#define DATE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+// ===== Dates locales "YYYY-MM-DD HH:MM:SS" sans localtime par ligne =====
+// Le préfixe "YYYY-MM-DD " du jour local est gardé avec l'intervalle UTC où il reste valable :
+// le jour local, raccourci au changement d'heure s'il en contient un (localisé une fois, par
+// dichotomie). Dans l'intervalle, une date ne coûte qu'une copie et l'heure du jour en
+// arithmétique ; hors intervalle, localtime_r (fuseau TZ courant) reconstruit le cache.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+static const size_t DATE_TIME_LEN = 19;  // "YYYY-MM-DD HH:MM:SS"
+
+// Fuseau de l'appareil (France). Posé dans setup() avant tout calcul de jour local : sinon les
+// boots de collecte découperaient les jours sur minuit UTC et les sessions WiFi sur minuit local.
+static const char *const DATE_TZ = "CET-1CEST,M3.5.0,M10.5.0/3";
+void dateSetTimezone();  // TZ = DATE_TZ, puis tzset()
+
+struct DateCache {
+  int64_t from = 1;      // Intervalle UTC [from, to) du préfixe (vide au départ)
+  int64_t to = 0;
+  int64_t midnight = 0;  // Minuit local du jour, en UTC, au décalage de l'intervalle
+  int32_t day = 0;       // Jour local (jours depuis 1970-01-01)
+  int64_t dayStart = 0;  // 00:00 locale du jour en UTC (≠ midnight si l'heure a changé avant)
+  char prefix[11];       // "YYYY-MM-DD "
+};
+
+char *fmtDateTime(DateCache &c, char *p, time_t t);  // Écrit DATE_TIME_LEN octets, retourne la fin
+
+// Créneaux en jours locaux (/api/query, agrégats) : jour local de t et son 00:00, même cache
+// que fmtDateTime
+int32_t dateLocalDay(DateCache &c, time_t t);
+time_t dateLocalMidnight(DateCache &c, time_t t);
+time_t dateDayStart(int32_t day);  // 00:00 locale de ce jour, en UTC (un localtime_r)
+
+#endif
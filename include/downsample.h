@@ -0,0 +1,32 @@
+#ifndef DOWNSAMPLE_H
+#define DOWNSAMPLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "web_app.h"
+
+// ===== Sous-échantillonnage LTTB (Largest-Triangle-Three-Buckets) =====
+// Choisit les points à tracer : premier et dernier conservés, puis un point par seau, celui qui
+// forme le plus grand triangle avec le point retenu précédent et la moyenne du seau suivant.
+// Les 7 canaux choisissent ensemble (une ligne = un temps commun) : l'aire est la somme des aires
+// par canal, chacune normalisée par l'amplitude du canal.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+struct DownsamplePoint {
+  uint32_t t;
+  float v[SAMPLE3_CHANNELS];  // NAN = absente
+};
+
+// Parcours séquentiel de la source depuis k = 0 (k croissant, trous permis) ; cb retourne false pour s'arrêter
+typedef std::function<bool(uint32_t k, const DownsamplePoint &p)> DownsampleVisitor;
+typedef std::function<void(const DownsampleVisitor &cb)> DownsampleSource;
+
+static const uint16_t DOWNSAMPLE_MIN_POINTS = 3;
+
+// Deux passes sur la source, mémoire temporaire : 32 octets par point demandé.
+// Écrit dans sel les indices retenus (croissants, au plus points) et retourne leur nombre ;
+// 0 si la mémoire manque (ou aucun point). points >= count : tous les points présents. count <= 65535.
+size_t lttbSelect(const DownsampleSource &src, uint32_t count, uint16_t points, uint16_t *sel);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef EPOCH_TABLE_H
+#define EPOCH_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===== Segments d'horloge =====
+// Les journaux gardent le temps brut de l'horloge ESP32 ; l'heure réelle est reconstruite à la
+// lecture : chaque segment [rawFrom, rawFrom du suivant) associe à ses temps bruts un décalage.
+// L'horloge brute ne recule jamais (voir epochSync / epochBoot), donc un temps brut désigne un
+// seul segment : recherche dichotomique, O(log segments) par échantillon, journaux jamais réécrits.
+// Dans un segment clos par une synchro, le décalage passe linéairement de sa valeur au début à
+// celle mesurée à la synchro (dérive répartie) : l'heure réelle reste continue et croissante
+// d'un segment à l'autre. Segment ouvert, ou après rawSync : décalage constant.
+// Temps brut avant le premier segment : décalage du premier.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+static const uint8_t EPOCH_MAX = 16;         // Segments conservés (table pleine : fusion, voir .cpp)
+static const int32_t EPOCH_MIN_STEP = 2;     // Écart de synchro ignoré en dessous (s)
+
+struct EpochSegment {
+  uint32_t rawFrom;    // Premier temps brut du segment
+  int32_t offset;      // Décalage à rawFrom (heure réelle = brut + décalage)
+  uint32_t rawSync;    // Synchro qui a clos le segment (= rawFrom tant qu'il est ouvert)
+  int32_t syncOffset;  // Décalage mesuré à rawSync (= offset tant qu'il est ouvert)
+};
+
+struct EpochTable {
+  uint32_t version;  // Change à chaque modification (ETag, snapshots)
+  uint8_t count;
+  EpochSegment seg[EPOCH_MAX];
+};
+
+// Copie SPIFFS de la table, relue par tools/compost_dump (la NVS n'est pas dans la partition) :
+// version(4) + count(1) + count x [rawFrom(4) offset(4) rawSync(4) syncOffset(4)], little-endian
+static const char EPOCH_FILE[] = "/epochs.bin";
+static const size_t EPOCH_RECORD_MAX = 5 + EPOCH_MAX * 16;
+
+size_t epochEncode(const EpochTable &tab, uint8_t *out);  // out >= EPOCH_RECORD_MAX ; retourne la taille
+bool epochDecode(const uint8_t *in, size_t len, EpochTable &tab);  // false si taille ou ordre invalide
+
+void epochInit(EpochTable &tab);  // Sans segment : décalage nul partout
+int32_t epochOffset(const EpochTable &tab, uint32_t raw);
+
+inline uint32_t epochReal(const EpochTable &tab, uint32_t raw) {
+  return raw + (uint32_t)epochOffset(tab, raw);
+}
+
+// Synchro : l'heure réelle valait realNow quand l'horloge brute indiquait rawNow. Le segment
+// courant est clos sur l'écart mesuré (jusque-là il était estimé) et un nouveau segment commence.
+// Retourne le temps brut auquel régler l'horloge : realNow si elle était en retard, sinon rawNow
+// (jamais de recul ; le nouveau segment garde alors l'écart négatif).
+uint32_t epochSync(EpochTable &tab, uint32_t rawNow, uint32_t realNow);
+
+// Démarrage à froid : l'horloge est repartie de zéro alors que lastRaw est déjà enregistré.
+// Nouveau segment après lastRaw, décalage du précédent en attendant une synchro.
+// Retourne le temps brut auquel régler l'horloge (lastRaw + 1).
+uint32_t epochBoot(EpochTable &tab, uint32_t lastRaw);
+
+#endif
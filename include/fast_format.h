@@ -0,0 +1,19 @@
+#ifndef FAST_FORMAT_H
+#define FAST_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===== Formatage numérique sans printf =====
+// Écrit à partir de p et retourne la nouvelle fin (pas de '\0').
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+static const size_t FMT_FIXED2_MAX = 11;  // "-9999999.99"
+static const size_t FMT_INT_MAX = 11;     // "-2147483648"
+
+bool fmtFixed2Ok(float v);            // Fini et |v| < 1e7 (sinon : null / nan selon le format)
+char *fmtFixed2(char *p, float v);    // 2 décimales arrondies, v vérifié par fmtFixed2Ok
+char *fmtUint(char *p, uint32_t v);
+char *fmtInt(char *p, int32_t v);
+
+#endif
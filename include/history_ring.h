@@ -0,0 +1,57 @@
+#ifndef HISTORY_RING_H
+#define HISTORY_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "web_app.h"
+
+// ===== Historique RAM compact =====
+// Stockage en colonnes (SoA) : 7 canaux int16 en centièmes + écart de temps uint16,
+// soit 16 octets par échantillon au lieu de sizeof(Sample3). Les sauts de temps
+// hors plage (coupure > 18 h, synchro de l'heure) sont conservés dans une petite
+// file d'ancres 32 bits. Conversion en Sample3 uniquement à la lecture.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+// Un seul écrivain (historyPush, historyClear) ; les lectures peuvent venir d'autres tâches
+// en parallèle, sans verrou : chaque échantillon rendu est cohérent (jamais à moitié écrit).
+
+// Capacité fixée à la compilation (build_flags = -DHISTORY_SIZE=...)
+#ifndef HISTORY_SIZE
+#define HISTORY_SIZE 600
+#endif
+
+static const size_t HISTORY_ANCHORS = 8;  // Sauts de temps simultanément conservés
+
+void historyPush(const Sample3 &s);
+void historyClear();
+size_t historyCount();
+bool historyLatest(Sample3 &s);  // false si historique vide
+
+// Parcourt l'historique du plus ancien au plus récent
+void historyForEach(const std::function<void(const Sample3 &)> &cb);
+
+// Numéros de séquence : chaque échantillon poussé reçoit historySeq() puis le compteur avance
+// (historyClear le fait sauter de HISTORY_SIZE). Les échantillons présents couvrent [first, end).
+uint32_t historySeq();
+void historyRange(uint32_t &first, uint32_t &end);  // Lus ensemble : cohérents entre eux
+
+// Parcourt à partir de la séquence fromSeq (ou du plus ancien présent) tant que cb retourne true.
+// Un échantillon évincé pendant le parcours est sauté (séquences croissantes, sans doublon).
+void historyForEachFrom(uint32_t fromSeq, const std::function<bool(uint32_t, const Sample3 &)> &cb);
+
+// Position de reprise d'un parcours (réponses découpées) : les temps se reconstruisent de proche
+// en proche, sans curseur chaque appel repart du plus ancien échantillon. Mise à jour avant
+// chaque cb : un appel suivant avec fromSeq >= seq reprend là où le précédent s'est arrêté.
+// Ignorée (reparcours depuis le plus ancien) si fromSeq est en arrière ou si la case a été évincée.
+struct HistoryCursor {
+  bool valid = false;
+  uint32_t seq = 0;     // Prochain échantillon
+  size_t idx = 0;       // Sa case dans le ring
+  uint32_t prevT = 0;   // Temps de l'échantillon précédent
+  uint32_t anchor = 0;  // Rang absolu de la prochaine ancre (voir anchorBase)
+};
+
+void historyForEachFrom(uint32_t fromSeq, const std::function<bool(uint32_t, const Sample3 &)> &cb,
+                        HistoryCursor &cursor);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef HISTORY_STREAM_H
+#define HISTORY_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "epoch_table.h"
+
+// ===== Réponses /api/history découpées (chunked) =====
+// Chaque requête ne garde qu'une position et un petit tampon : la mémoire reste constante
+// quel que soit le nombre de points, et le TCP tire les octets au rythme de sa fenêtre.
+
+enum HistoryResolution { HISTORY_RAW, HISTORY_HOUR, HISTORY_DAY };
+
+enum HistoryFormat {
+  HISTORY_FORMAT_ROWS,     // [{"t":..,"b1":{"tempC":..,...},...}, ...] (défaut)
+  HISTORY_FORMAT_COLUMNS,  // {"t0":..,"dt":[..],"b1":{"tempC":[..],...},...}
+  HISTORY_FORMAT_BINARY    // Colonnes little-endian, voir ci-dessous
+};
+
+// Colonnes (JSON et binaire) : t0 = temps du premier point, dt = écart avec le point précédent
+// (dt[0] = 0). Agrégats : "n" puis moyennes, "min":{...} et "max":{...}, mêmes clés que les lignes.
+//
+// Binaire (little-endian) :
+//   0   u16  magic 0x4843 ("CH")
+//   2   u8   version (1)
+//   3   u8   drapeaux : bit 0 = agrégats (n/min/max présents)
+//   4   u16  nombre de points N
+//   6   u16  nombre de canaux (7, ordre CSV)
+//   8   u32  t0 (epoch)
+//   12  u32  dt[N]
+//       u16  n[N]                    (agrégats)
+//       i16  moy[7][N]               centièmes, -32768 = absent
+//       i16  min[7][N], max[7][N]    (agrégats)
+static const uint16_t HISTORY_BIN_MAGIC = 0x4843;
+static const uint8_t HISTORY_BIN_VERSION = 1;
+static const uint8_t HISTORY_BIN_ROLLUP = 0x01;
+
+struct HistoryStream;
+
+// nullptr si la mémoire manque. maxPoints : derniers points renvoyés (agrégats).
+// since : seuls les points postérieurs au dernier point daté <= since (temps exporté) ; 0 = tous.
+// points : au plus points points choisis par LTTB (downsample.h) ; les agrégats couvrent alors
+// tout le niveau au lieu des maxPoints derniers. 0 = pas de sous-échantillonnage.
+static const uint16_t HISTORY_POINTS_MAX = 500;  // 16 Ko temporaires (downsample.h)
+
+HistoryStream *historyStreamCreate(HistoryResolution res, HistoryFormat fmt, const EpochTable &epochs,
+                                   size_t maxPoints, uint32_t since = 0, uint16_t points = 0);
+void historyStreamFree(HistoryStream *st);
+size_t historyStreamFill(HistoryStream &st, uint8_t *buf, size_t maxLen);  // 0 = fin
+// Brut : séquence suivant le dernier point de la réponse (= id SSE de ce point), 0 pour les agrégats
+uint32_t historyStreamEnd(const HistoryStream &st);
+const char *historyStreamContentType(HistoryFormat fmt);
+
+#endif
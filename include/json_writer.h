@@ -0,0 +1,77 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "web_app.h"
+#include "rollup.h"
+#include "fast_format.h"
+
+// ===== Écriture JSON sans allocation =====
+// Écrit dans un tampon fourni par l'appelant ; en cas de dépassement, length() vaut 0.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+class JsonOut {
+ public:
+  JsonOut(char *buf, size_t cap) : buf(buf), cap(cap) {}
+
+  void raw(const char *s, size_t n) {
+    if (!reserve(n)) return;
+    memcpy(buf + len, s, n);
+    len += n;
+  }
+  template <size_t N>
+  void lit(const char (&s)[N]) { raw(s, N - 1); }  // Littéral : longueur connue à la compilation
+
+  void fixed2(float v);   // 2 décimales, null si absente
+  void integer(int32_t v);
+  void uinteger(uint32_t v);
+
+  size_t length() const { return over ? 0 : len; }
+
+ private:
+  char *buf;
+  size_t cap;
+  size_t len = 0;
+  bool over = false;
+  bool reserve(size_t n) {
+    if (over || len + n > cap) {
+      over = true;
+      return false;
+    }
+    return true;
+  }
+};
+
+// ===== Descripteurs de champs =====
+// Chaque canal est précédé d'un fragment JSON constant (clé + ponctuation) : la sérialisation
+// se réduit à une copie de littéral et un nombre en virgule fixe par canal.
+struct JsonField {
+  const char *prefix;
+  uint8_t prefixLen;
+  uint8_t ch;  // Canal Sample3 (ordre CSV)
+};
+
+#define JSON_FIELD(p, ch) {p, sizeof(p) - 1, ch}
+
+static constexpr JsonField SAMPLE3_JSON_FIELDS[SAMPLE3_CHANNELS] = {
+  JSON_FIELD("\"b1\":{\"tempC\":", 0),
+  JSON_FIELD(",\"humPct\":", 1),
+  JSON_FIELD(",\"o2Pct\":", 2),
+  JSON_FIELD("},\"b2\":{\"tempC\":", 3),
+  JSON_FIELD(",\"humPct\":", 4),
+  JSON_FIELD("},\"b3\":{\"tempC\":", 5),
+  JSON_FIELD(",\"humPct\":", 6),
+};
+
+// Sérialisations de l'API (même forme que /api/latest et /api/history).
+// Retournent la longueur écrite, 0 si le tampon est trop petit. tOffset : décalage horaire
+// (les créneaux d'agrégats sont déjà en heure réelle).
+static const size_t JSON_SAMPLE_MAX = 192;
+static const size_t JSON_ROLLUP_MAX = 512;
+
+size_t jsonSample(char *out, size_t cap, const Sample3 &s, int32_t tOffset);
+size_t jsonRollup(char *out, size_t cap, const RollupBucket &b);
+
+#endif
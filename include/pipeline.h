@@ -0,0 +1,49 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include "web_app.h"
+
+// ===== Pipeline du mode WiFi =====
+// Trois tâches FreeRTOS épinglées, reliées par deux files SPSC (spsc_queue.h) :
+//   acquisition (cœur 1) --pipelinePush--> file flash  --> écriture flash (cœur 0, priorité basse)
+//                                      \-> file réseau --> historique RAM + SSE (cœur 1)
+// Une écriture SPIFFS lente (ramasse-miettes, recherche de page) ne retarde ni la mesure
+// suivante ni les réponses HTTP : seule la file flash se remplit. File pleine : échantillon
+// compté comme perdu pour ce consommateur, le producteur ne bloque jamais.
+// Hors WiFi (mesure unique puis deep sleep), main.cpp écrit directement sans pipeline.
+
+static const uint32_t PIPELINE_QUEUE_SIZE = 16;  // Échantillons par file (puissance de 2)
+
+typedef void (*PipelineSink)(const Sample3 &s);
+typedef bool (*PipelineSource)(Sample3 &s);  // Mesure bloquante ; false = rien à pousser
+
+// Démarre les tâches flash et réseau (consommateurs)
+void pipelineBegin(PipelineSink persist, PipelineSink publish);
+// Démarre la tâche d'acquisition : une mesure toutes les periodMs
+void pipelineStartSampler(PipelineSource acquire, uint32_t periodMs);
+// Jamais bloquant ; false si au moins une file était pleine
+bool pipelinePush(const Sample3 &s);
+// Arrête l'acquisition ; une fois la tâche d'acquisition arrêtée, laisse les consommateurs vider
+// leur file puis les arrête. false si une tâche n'a pas rendu la main à temps : elle tourne
+// encore (écrivain flash possible) et des échantillons peuvent rester en file (comptés au log).
+bool pipelineStop();
+
+struct PipelineQueueStats {
+  uint32_t depth;      // Échantillons en attente
+  uint32_t highWater;  // Profondeur maximale atteinte
+  uint32_t capacity;
+  uint32_t pushed;     // Acceptés depuis le démarrage
+  uint32_t drops;      // Refusés (file pleine)
+};
+
+struct PipelineStats {
+  PipelineQueueStats storage, web;
+  uint32_t samples;        // Mesures faites par la tâche d'acquisition
+  uint32_t persistMaxUs;   // Pire durée d'une écriture flash (storagePersist)
+  uint32_t publishMaxUs;   // Pire durée d'une diffusion (historique + SSE)
+};
+
+void pipelineStats(PipelineStats &st);
+
+#endif
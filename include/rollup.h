@@ -0,0 +1,49 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "web_app.h"
+
+// ===== Agrégats multi-résolution (min/max/moyenne/nombre par canal) =====
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+enum RollupTier {
+  ROLLUP_HOUR = 0,
+  ROLLUP_DAY = 1,
+  ROLLUP_TIER_COUNT = 2
+};
+
+struct RollupChannel {
+  int16_t min, max;    // centièmes d'unité
+  int32_t sum;         // somme des valeurs finies (centièmes)
+  uint16_t count;      // nombre de valeurs finies
+};
+
+struct RollupBucket {
+  uint32_t start;      // début du créneau (heure réelle, epoch ; jour : 00:00 locale)
+  uint16_t samples;    // échantillons reçus dans le créneau
+  RollupChannel ch[SAMPLE3_CHANNELS];
+};
+
+// Enregistrement flash : start(4) + samples(2) + 7 x [moyenne(2) min(2) max(2)], centièmes,
+// little-endian ; canal sans valeur : min = ROLLUP_NO_VALUE. La somme et le nombre de valeurs
+// par canal ne servent qu'au créneau ouvert (RAM) et ne sont pas stockés.
+static const size_t ROLLUP_RECORD_SIZE = 6 + SAMPLE3_CHANNELS * 6;
+static const int16_t ROLLUP_NO_VALUE = -32768;  // Hors plage de toCenti (±32767)
+
+uint32_t rollupPeriod(RollupTier tier);  // Nominale : un jour local dure 23 à 25 h
+// t en heure réelle ; heure alignée sur l'epoch, jour sur minuit local (TZ courant)
+uint32_t rollupBucketStart(RollupTier tier, uint32_t t);
+
+void rollupReset(RollupBucket &b, uint32_t start);
+void rollupAdd(RollupBucket &b, const Sample3 &s);
+
+float rollupMean(const RollupChannel &c);  // NAN si aucune valeur
+float rollupMin(const RollupChannel &c);
+float rollupMax(const RollupChannel &c);
+
+void rollupEncode(const RollupBucket &b, uint8_t *out);
+void rollupDecode(const uint8_t *in, RollupBucket &b);
+
+#endif
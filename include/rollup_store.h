@@ -0,0 +1,36 @@
+#ifndef ROLLUP_STORE_H
+#define ROLLUP_STORE_H
+
+#include <functional>
+#include "rollup.h"
+
+// ===== Agrégats persistés en flash =====
+// Le créneau ouvert de chaque niveau vit en mémoire RTC (survit au deep sleep) ;
+// il est ajouté au fichier du niveau dès qu'un échantillon tombe dans le créneau suivant.
+// Créneaux datés en heure réelle (table d'epochs appliquée à l'écriture).
+//
+// Rétention : deux générations par niveau. Quand le fichier courant atteint ROLLUP_GEN_RECORDS,
+// il remplace l'ancienne génération (.old) et un fichier vide reprend : l'espace occupé reste
+// borné à 2 x ROLLUP_GEN_RECORDS enregistrements (~140 Ko par niveau).
+
+static const char* const ROLLUP_FILES[ROLLUP_TIER_COUNT] = {"/hour.bin", "/day.bin"};
+static const char* const ROLLUP_OLD_FILES[ROLLUP_TIER_COUNT] = {"/hour.old", "/day.old"};
+static const size_t ROLLUP_GEN_RECORDS[ROLLUP_TIER_COUNT] = {1464, 732};  // ~2 mois / ~2 ans
+
+void rollupStoreBegin();                 // Supprime les fichiers d'agrégats de l'ancien format
+void rollupStorePush(const Sample3 &s);  // Mise à jour incrémentale (hour + day)
+
+// Parcourt les maxRecords derniers créneaux (du plus ancien au plus récent), créneau ouvert inclus
+void rollupStoreForEach(RollupTier tier, size_t maxRecords,
+                        const std::function<void(const RollupBucket &)> &cb);
+
+// Lecture par position (réponses HTTP découpées) : index absolus, croissants du plus ancien
+// créneau fermé (ancienne génération puis courante) au créneau ouvert éventuel, présents dans
+// [first, end). Une rotation retire les plus anciens sans décaler les autres.
+// ForEachFrom parcourt depuis first (ou le plus ancien présent) tant que cb retourne true ;
+// cb est appelé sous le verrou des agrégats et ne doit pas rappeler ce module.
+void rollupStoreRange(RollupTier tier, size_t &first, size_t &end);
+void rollupStoreForEachFrom(RollupTier tier, size_t first,
+                            const std::function<bool(size_t, const RollupBucket &)> &cb);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// ===== File sans verrou, un producteur / un consommateur =====
+// Tampon circulaire de N éléments (puissance de 2), compteurs libres 32 bits : push() n'est
+// appelé que par une tâche, pop() que par une autre, sans verrou ni attente. File pleine :
+// l'élément est refusé et compté (drops), le producteur ne bloque jamais.
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+template <typename T, uint32_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "N doit être une puissance de 2");
+
+ public:
+  // Producteur seulement
+  bool push(const T &v) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t depth = h - tail.load(std::memory_order_acquire);
+    if (depth >= N) {
+      drops.store(drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    buf[h & (N - 1)] = v;
+    head.store(h + 1, std::memory_order_release);  // Publie l'élément au consommateur
+    if (depth + 1 > maxDepth.load(std::memory_order_relaxed)) {
+      maxDepth.store(depth + 1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  // Consommateur seulement ; false si vide
+  bool pop(T &v) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    v = buf[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);  // Libère la case au producteur
+    return true;
+  }
+
+  // ---------- Compteurs (lisibles depuis n'importe quelle tâche) ----------
+  uint32_t depth() const {
+    uint32_t t = tail.load(std::memory_order_acquire);
+    return head.load(std::memory_order_acquire) - t;
+  }
+  uint32_t pushed() const { return head.load(std::memory_order_relaxed); }
+  uint32_t dropped() const { return drops.load(std::memory_order_relaxed); }
+  uint32_t highWater() const { return maxDepth.load(std::memory_order_relaxed); }
+  static constexpr uint32_t capacity() { return N; }
+
+ private:
+  T buf[N];
+  std::atomic<uint32_t> head{0};      // Écrit par le producteur
+  std::atomic<uint32_t> tail{0};      // Écrit par le consommateur
+  std::atomic<uint32_t> drops{0};     // Écrit par le producteur
+  std::atomic<uint32_t> maxDepth{0};  // Écrit par le producteur
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <stddef.h>
+#include "web_app.h"
+
+// ===== Persistance flash (CSV + agrégats + archive) =====
+void storageBegin();                    // Après SPIFFS.begin : récupération des journaux
+bool storagePersist(const Sample3 &s);  // true si la ligne CSV est acceptée (lot en RAM, voir csv_log.h)
+bool storageFlush();                    // Lot CSV en attente -> flash ; true si tout est écrit
+
+bool storageTruncate(const char *path, size_t len);  // Tronque un fichier SPIFFS via le VFS
+
+#endif
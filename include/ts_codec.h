@@ -0,0 +1,70 @@
+#ifndef TS_CODEC_H
+#define TS_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "web_app.h"
+
+// ===== Blocs compressés de séries temporelles =====
+// Bloc de taille fixe : en-tête 16 octets + flux de bits (MSB d'abord).
+//  - timestamps : delta-of-delta, codes '0' | '10'+7 | '110'+9 | '1110'+12 | '1111'+32
+//  - canaux (centièmes) : delta zigzag, codes '0' | '10'+6 | '110'+10 | '1110'+16 | '11110'+32 brut | '11111' NAN
+// Un bloc est scellé une fois plein ; le CRC couvre le flux utilisé (blocs ouverts compris).
+// Code portable (aucune dépendance Arduino) : partagé firmware / outils PC.
+
+static const size_t TS_BLOCK_SIZE = 512;
+static const size_t TS_BLOCK_HEADER = 16;
+static const uint16_t TS_BLOCK_MAGIC = 0x5354;  // "TS"
+static const uint8_t TS_BLOCK_SEALED = 0x01;
+
+// En-tête (little-endian) :
+//  0 magic u16 | 2 count u16 | 4 t0 u32 | 8 bitLen u16 | 10 crc u16 | 12 flags u8 | 13..15 réservé
+
+class TsBlockEncoder {
+ public:
+  void begin(uint8_t *block);       // Bloc vide
+  bool resume(uint8_t *block);      // Reprendre un bloc ouvert valide (false -> appeler begin)
+  bool append(const Sample3 &s);    // false si le bloc est plein (bloc inchangé)
+  void commit();                    // Met à jour count/bitLen/CRC de l'en-tête
+  void seal();                      // commit + drapeau scellé
+
+  uint16_t count() const { return n; }
+  size_t usedBytes() const { return TS_BLOCK_HEADER + (bitPos + 7) / 8; }
+
+ private:
+  uint8_t *blk;
+  uint32_t bitPos;
+  uint16_t n;
+  uint32_t prevT;
+  int32_t prevDelta;
+  int32_t prevVal[SAMPLE3_CHANNELS];
+
+  bool writeBits(uint32_t v, int bits);
+  bool writeTime(uint32_t t);
+  bool writeValue(int ch, float v);
+};
+
+class TsBlockDecoder {
+ public:
+  bool begin(const uint8_t *block);  // Vérifie magic + CRC
+  bool next(Sample3 &s);             // Échantillon suivant (false en fin de bloc)
+
+  uint16_t count() const { return n; }
+  bool sealed() const;
+  uint32_t firstTime() const;
+
+ private:
+  friend class TsBlockEncoder;  // resume() reprend l'état après décodage
+
+  const uint8_t *blk;
+  uint32_t bitPos, bitLen;
+  uint16_t n, idx;
+  uint32_t prevT;
+  int32_t prevDelta;
+  int32_t prevVal[SAMPLE3_CHANNELS];
+
+  bool readBits(int bits, uint32_t &v);
+  int readPrefix(int maxOnes);
+};
+
+#endif
@@ -11,6 +11,33 @@ struct Sample3 {
   float b3Temp, b3Hum;         // Bac 3
 };
 
+// Accès indexé aux 7 canaux (ordre des colonnes CSV)
+static const int SAMPLE3_CHANNELS = 7;
+
+inline float sample3Get(const Sample3 &s, int ch) {
+  switch (ch) {
+    case 0: return s.b1Temp;
+    case 1: return s.b1Hum;
+    case 2: return s.b1O2;
+    case 3: return s.b2Temp;
+    case 4: return s.b2Hum;
+    case 5: return s.b3Temp;
+    default: return s.b3Hum;
+  }
+}
+
+inline void sample3Set(Sample3 &s, int ch, float v) {
+  switch (ch) {
+    case 0: s.b1Temp = v; break;
+    case 1: s.b1Hum = v; break;
+    case 2: s.b1O2 = v; break;
+    case 3: s.b2Temp = v; break;
+    case 4: s.b2Hum = v; break;
+    case 5: s.b3Temp = v; break;
+    default: s.b3Hum = v; break;
+  }
+}
+
 // ===== API Web =====
 void webInit();           // Initialiser WiFi AP + serveur web
 void webStop();           // Arrêter WiFi AP + serveur web
@@ -0,0 +1,27 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// ===== Ressources de l'IHM précompressées =====
+// include/web_assets_gz.h est généré avant chaque compilation par tools/gzip_assets.py
+// (extra_scripts, platformio.ini) : page, CSS et JS gzip en PROGMEM, avec empreinte de contenu.
+// Sans fichier généré, la page est servie non compressée depuis web_page.h.
+
+struct WebAsset {
+  const char *path;         // URL servie
+  const char *contentType;
+  const uint8_t *gz;        // Contenu gzip (PROGMEM)
+  size_t len;
+  const char *etag;         // Empreinte du contenu, entre guillemets
+  const char *version;      // ?v= attendu pour un cache permanent ; "" = revalidation systématique
+};
+
+#if __has_include("web_assets_gz.h")
+#include "web_assets_gz.h"
+#define WEB_ASSETS_GZ 1
+#else
+#define WEB_ASSETS_GZ 0
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 #define WEB_PAGE_H
 
 // ===== Page HTML de l'IHM =====
+// Source unique : tools/gzip_assets.py en tire les ressources gzip servies par le firmware.
 static const char INDEX_HTML[] = R"HTML(
 <!doctype html>
 <html lang="fr">
@@ -87,7 +88,7 @@ static const char INDEX_HTML[] = R"HTML(
     }
     .tab.active{outline:2px solid rgba(255,255,255,.18)}
 
-    button{
+    button, select{
       padding:9px 12px; border-radius:12px;
       border:1px solid var(--border);
       background: rgba(255,255,255,.05);
@@ -112,6 +113,13 @@ static const char INDEX_HTML[] = R"HTML(
     th,td{padding:8px 10px; border-bottom:1px solid var(--border); font-size:13px}
     th{color:var(--muted); text-align:left; font-weight:900}
     td{color:var(--text)}
+    .tableScroll{max-height:380px; overflow-y:auto; margin-top:10px; border-radius:12px}
+    .tableScroll table{margin-top:0}
+    .tableScroll th{position:sticky; top:0; background:#101a2e}
+    .tableScroll tbody tr{height:34px}
+    .tableScroll td{white-space:nowrap}
+    .tableScroll tr.pad{height:0}
+    .tableScroll tr.pad td{padding:0; border:0}
     .foot{color:var(--muted); font-size:12px; margin-top:10px}
     .err{color: var(--bad); font-weight:900}
 
@@ -234,6 +242,11 @@ static const char INDEX_HTML[] = R"HTML(
             <button class="tab" id="tab2">Bac 2</button>
             <button class="tab" id="tab3">Bac 3</button>
           </div>
+          <select id="resSel" title="Résolution de l'historique">
+            <option value="raw">Brut</option>
+            <option value="hour">Horaire</option>
+            <option value="day">Journalier</option>
+          </select>
           <button id="reload">Recharger l'historique</button>
           <button id="pauseBtn">Pause</button>
         </div>
@@ -281,13 +294,15 @@ static const char INDEX_HTML[] = R"HTML(
     <!-- Table + CSV -->
     <div class="card span-4">
       <div class="k">Dernières mesures</div>
-      <div class="foot">Table du bac sélectionné (10 dernières)</div>
-      <table>
-        <thead>
-          <tr><th>t (s)</th><th>Temp</th><th>Hum</th><th>O₂</th></tr>
-        </thead>
-        <tbody id="rows"></tbody>
-      </table>
+      <div class="foot">Table du bac sélectionné (tout l'historique chargé, défilement)</div>
+      <div class="tableScroll" id="tableScroll">
+        <table>
+          <thead>
+            <tr><th>t (s)</th><th>Temp</th><th>Hum</th><th>O₂</th></tr>
+          </thead>
+          <tbody id="rows"></tbody>
+        </table>
+      </div>
 
       <div class="btnRow">
         <button id="csvBtn">Télécharger CSV (Bac sélectionné)</button>
@@ -302,6 +317,430 @@ static const char INDEX_HTML[] = R"HTML(
   </div>
 </div>
 
+<script id="dataWorker" type="text/js-worker">
+  // ========= Worker de données =========
+  // Décodage de /api/history, store, cache IndexedDB, seuils et réduction par pixel tournent ici,
+  // hors du thread de l'IHM, qui ne fait que dessiner les tableaux reçus.
+  // Messages reçus : init {origin, px, rowCount}, start, px {px}, resolution {resolution},
+  //                  load {full, resync}, sample {json, id}, rows {first}
+  // Messages émis  : frame (voir postFrame), rows (voir tableWindow), cards {t, v, lvl}, status {hint, err}
+  // Chargé depuis un Blob par le script principal : les URL de fetch doivent être absolues.
+  let origin = '';
+  let resolution = 'raw'; // 'raw'|'hour'|'day' (agrégats flash)
+  let px = 400;           // Largeur du tracé visible (px CSS)
+  let rowFirst = 0;       // Fenêtre de la table : rowCount lignes à partir de la rowFirst-ième plus récente
+  let rowCount = 24;
+  let lastSeq = 0;        // id SSE du dernier échantillon brut dans le store (0 = inconnu)
+
+  // ========= Store colonnaire =========
+  // Anneau de Float32Array (un par canal, ordre BIN_KEYS) + temps en Float64Array : ajout en O(1)
+  // sans allocation, le plus ancien est écrasé. Min/max par canal tenus à jour à l'ajout ; recalcul
+  // seulement si l'échantillon écrasé était un extrême.
+  // Capacité : historique local (cache IndexedDB), bien au-delà du ring de l'ESP32 (HISTORY_SIZE)
+  const STORE_MAX = 20000;
+  const NCH = 7;
+  const store = {
+    cap: STORE_MAX, len: 0, head: 0, gen: 0,  // gen : change à chaque remise à zéro
+    t: new Float64Array(STORE_MAX),
+    ch: Array.from({length: NCH}, ()=>new Float32Array(STORE_MAX)),
+    lo: new Float32Array(NCH).fill(Infinity),
+    hi: new Float32Array(NCH).fill(-Infinity),
+    dirty: new Uint8Array(NCH)
+  };
+
+  function storeIdx(i){ return (store.head + i) % store.cap; }
+  function storeT(i){ return store.t[storeIdx(i)]; }
+  function storeLastT(){ return store.len ? storeT(store.len - 1) : -Infinity; }
+
+  function storeClear(){
+    store.len = 0;
+    store.head = 0;
+    store.gen++;
+    store.lo.fill(Infinity);
+    store.hi.fill(-Infinity);
+    store.dirty.fill(0);
+  }
+
+  // vals : NCH valeurs (NaN = absente)
+  function storePush(t, vals){
+    let k;
+    if(store.len < store.cap){
+      k = storeIdx(store.len);
+      store.len++;
+    } else {
+      k = store.head;
+      store.head = (store.head + 1) % store.cap;
+      for(let c = 0; c < NCH; c++){
+        const old = store.ch[c][k];
+        if(old === store.lo[c] || old === store.hi[c]) store.dirty[c] = 1;
+      }
+    }
+    store.t[k] = t;
+    for(let c = 0; c < NCH; c++){
+      const col = store.ch[c];
+      col[k] = vals[c];
+      const v = col[k];  // Valeur arrondie en float32, comme lo/hi
+      if(store.dirty[c] || v !== v) continue;
+      if(v < store.lo[c]) store.lo[c] = v;
+      if(v > store.hi[c]) store.hi[c] = v;
+    }
+  }
+
+  // Colonnes décodées ({n, t, ch}), points déjà connus ignorés
+  function storeAppend(cols){
+    const vals = new Array(NCH);
+    for(let i = 0; i < cols.n; i++){
+      if(cols.t[i] <= storeLastT()) continue;
+      for(let c = 0; c < NCH; c++) vals[c] = cols.ch[c][i];
+      storePush(cols.t[i], vals);
+    }
+  }
+
+  // {lo, hi} des valeurs finies du canal (lo > hi si aucune)
+  function storeRange(c){
+    if(store.dirty[c]){
+      let lo = Infinity, hi = -Infinity;
+      const col = store.ch[c];
+      for(let i = 0; i < store.len; i++){
+        const v = col[storeIdx(i)];
+        if(v < lo) lo = v;
+        if(v > hi) hi = v;
+      }
+      store.lo[c] = lo;
+      store.hi[c] = hi;
+      store.dirty[c] = 0;
+    }
+    return {lo: store.lo[c], hi: store.hi[c]};
+  }
+
+  // Valeurs de la ligne i, ordre des canaux
+  function storeValues(i){
+    const k = storeIdx(i);
+    return Array.from(store.ch, (col)=>col[k]);
+  }
+
+  // ========= Réduction par pixel =========
+  // m = min(n, px) créneaux consécutifs de points ; pour chaque canal : dernière valeur du
+  // créneau (courbe, survol, marqueurs) et min/max du créneau (trait vertical), pour
+  // qu'aucun pic ne disparaisse quand plusieurs points tombent sur le même pixel.
+  // Si m = n, chaque créneau est un point : tracé identique au tracé point par point.
+  let frameSeq = 0;
+  let frameTimer = 0;
+  function scheduleFrame(){
+    if(!frameTimer) frameTimer = setTimeout(()=>{ frameTimer = 0; postFrame(); }, 0);
+  }
+
+  // frame : {seq, n, m, t[m], v/lo/hi : NCH x Float32Array(m), rlo/rhi : plage de chaque canal
+  // sur tout le store, table : fenêtre de la table (voir tableWindow)}
+  function postFrame(){
+    const n = store.len, m = Math.min(n, Math.max(2, px | 0));
+    const t = new Float64Array(m);
+    const v = [], lo = [], hi = [];
+    const transfer = [t.buffer];
+    for(let b = 0; b < m; b++) t[b] = storeT(Math.floor((b + 1) * n / m) - 1);
+    for(let c = 0; c < NCH; c++){
+      const col = store.ch[c];
+      const cv = new Float32Array(m), clo = new Float32Array(m), chi = new Float32Array(m);
+      let i = 0, k = store.head;
+      for(let b = 0; b < m; b++){
+        const end = Math.floor((b + 1) * n / m);
+        let bl = NaN, bh = NaN, last = NaN;
+        for(; i < end; i++, k = (k + 1 === store.cap) ? 0 : k + 1){
+          const x = col[k];
+          last = x;
+          if(x !== x) continue;  // NaN
+          if(!(x >= bl)) bl = x;
+          if(!(x <= bh)) bh = x;
+          last = x;
+        }
+        cv[b] = last;
+        clo[b] = bl;
+        chi[b] = bh;
+      }
+      v.push(cv);
+      lo.push(clo);
+      hi.push(chi);
+      transfer.push(cv.buffer, clo.buffer, chi.buffer);
+    }
+    const rlo = [], rhi = [];
+    for(let c = 0; c < NCH; c++){
+      const r = storeRange(c);
+      rlo.push(r.lo);
+      rhi.push(r.hi);
+    }
+    postMessage({type: 'frame', seq: ++frameSeq, n, m, t, v, lo, hi, rlo, rhi, table: tableWindow()}, transfer);
+  }
+
+  // {len, first, gen, rows} : lignes [t, v0..v6] d'indices first.. (0 = plus récente), len = taille du store
+  function tableWindow(){
+    const n = store.len;
+    rowFirst = Math.max(0, Math.min(rowFirst, n - rowCount));
+    const rows = [];
+    for(let i = n - 1 - rowFirst; i >= Math.max(0, n - rowFirst - rowCount); i--) rows.push([storeT(i), ...storeValues(i)]);
+    return {len: n, first: rowFirst, gen: store.gen, rows};
+  }
+
+  // ===== Badges simples =====
+  function rank(lvl){ return lvl==='bad'?2 : lvl==='warn'?1 : lvl==='ok'?0 : -1; }
+  function worstOf(levels){
+    const xs = levels.filter(x=>x);
+    if(xs.length===0) return null;
+    return xs.sort((a,b)=>rank(b)-rank(a))[0];
+  }
+  function evalTemp(t){ if(!isFinite(t)) return {lvl:null}; if(t>=65) return {lvl:'bad'}; if(t>=55) return {lvl:'warn'}; return {lvl:'ok'}; }
+  function evalHum(h){ if(!isFinite(h)) return {lvl:null}; if(h<=35||h>=85) return {lvl:'bad'}; if(h<=45||h>=75) return {lvl:'warn'}; return {lvl:'ok'}; }
+  function evalO2(o){ if(!isFinite(o)) return {lvl:null}; if(o<=18.5) return {lvl:'bad'}; if(o<=19.5) return {lvl:'warn'}; return {lvl:'ok'}; }
+
+  // Cartes : valeurs (ordre des canaux) + niveau de chaque bac (lvl[0] = Bac 1)
+  function postCards(t, v){
+    postMessage({type: 'cards', t, v, lvl: [
+      worstOf([evalTemp(v[0]).lvl, evalHum(v[1]).lvl, evalO2(v[2]).lvl]),
+      worstOf([evalTemp(v[3]).lvl, evalHum(v[4]).lvl]),
+      worstOf([evalTemp(v[5]).lvl, evalHum(v[6]).lvl])]});
+  }
+  function postLastCards(){
+    if(store.len) postCards(storeT(store.len - 1), storeValues(store.len - 1));
+  }
+
+  function status(hint, err){
+    postMessage({type: 'status', hint, err: err || ''});
+  }
+
+  // Décodage du format binaire de /api/history (voir history_stream.h) en colonnes :
+  // {n, t: Float64Array, ch: [Float32Array x 7]} (moyennes pour les agrégats, NaN = absente)
+  const BIN_KEYS = [['b1','tempC'],['b1','humPct'],['b1','o2Pct'],['b2','tempC'],['b2','humPct'],['b3','tempC'],['b3','humPct']];
+  function decodeHistoryBin(buf){
+    const dv = new DataView(buf);
+    if (buf.byteLength < 12 || dv.getUint16(0, true) !== 0x4843 || dv.getUint8(2) !== 1) throw new Error('format binaire inconnu');
+    const rollup = (dv.getUint8(3) & 1) !== 0;
+    const n = dv.getUint16(4, true), nch = dv.getUint16(6, true);
+    let off = 12;
+    const t = new Float64Array(n);
+    let tt = dv.getUint32(8, true);
+    for (let i = 0; i < n; i++, off += 4){
+      tt += dv.getUint32(off, true);
+      t[i] = tt;
+    }
+    if (rollup) off += 2 * n;  // Nombre d'échantillons par créneau : non tracé
+    const ch = [];
+    for (let c = 0; c < nch; c++, off += 2 * n){
+      if (c >= NCH) continue;
+      const col = new Float32Array(n);
+      for (let i = 0; i < n; i++){
+        const v = dv.getInt16(off + 2 * i, true);
+        col[i] = (v === -32768) ? NaN : v / 100;
+      }
+      ch.push(col);
+    }
+    while (ch.length < NCH) ch.push(new Float32Array(n).fill(NaN));
+    return {n, t, ch};
+  }
+
+  // Échantillon JSON (SSE, /api/latest) -> valeurs dans l'ordre des canaux
+  function sampleValues(d){
+    return BIN_KEYS.map(([b, k])=>{
+      const v = (d[b] || {})[k];
+      return (v === null || v === undefined) ? NaN : Number(v);
+    });
+  }
+
+  // ========= Cache local (IndexedDB) =========
+  // Échantillons bruts conservés par appareil d'une visite à l'autre : affichage immédiat au
+  // chargement, puis seuls les points plus récents que le dernier en cache sont demandés.
+  // Sans IndexedDB (navigation privée...), l'IHM fonctionne comme avant, sans cache.
+  // Les temps sont des heures réelles : une synchro peut redater des points déjà en cache
+  // (segments d'horloge, epoch_table.h). La table vue à la visite précédente est gardée ; les
+  // points dont la datation a changé depuis sont supprimés, puis rechargés s'ils sont encore
+  // dans le ring de l'ESP32.
+  const CACHE_DB = 'compost-ihm';
+  const CACHE_STORE = 'samples';  // {d: appareil, t, v: [7 valeurs]}, clé [d, t]
+  const CACHE_META = 'meta';      // {d: appareil, epochs: segments de /api/info}, clé d
+  let cacheDb = null;
+  let deviceId = null;
+
+  function idbRequest(r){
+    return new Promise((resolve, reject)=>{ r.onsuccess = ()=>resolve(r.result); r.onerror = ()=>reject(r.error); });
+  }
+  function deviceRange(fromT, toT){
+    return IDBKeyRange.bound([deviceId, fromT], [deviceId, toT], false, true);
+  }
+
+  // Même calcul que epochOffset (epoch_table.cpp) ; seg = [rawFrom, offset, rawSync, syncOffset]
+  function epochReal(tab, raw){
+    if(!tab.length) return raw;
+    let i = tab.length - 1;
+    while(i > 0 && tab[i][0] > raw) i--;
+    const [from, off, sync, soff] = tab[i];
+    if(raw <= from) return raw + off;
+    if(raw >= sync) return raw + soff;
+    return raw + off + Math.trunc((soff - off) * (raw - from) / (sync - from));
+  }
+
+  // Premier temps réel (selon l'ancienne table) dont la datation a changé, Infinity si aucun :
+  // avant le premier segment différent, les deux tables datent les temps bruts à l'identique
+  function redatedFrom(oldTab, newTab){
+    let i = 0;
+    while(i < oldTab.length && i < newTab.length && oldTab[i].join() === newTab[i].join()) i++;
+    if(i === oldTab.length && i === newTab.length) return Infinity;
+    if(i === 0) return 0;
+    const raw = Math.min(i < oldTab.length ? oldTab[i][0] : Infinity, i < newTab.length ? newTab[i][0] : Infinity);
+    return epochReal(oldTab, raw);
+  }
+
+  async function cacheOpen(){
+    try{
+      const info = await (await fetch(origin + '/api/info', {cache:'no-store'})).json();
+      if(!self.indexedDB || !info.device) return;
+      const r = indexedDB.open(CACHE_DB, 2);
+      r.onupgradeneeded = ()=>{
+        const names = r.result.objectStoreNames;
+        if(!names.contains(CACHE_STORE)) r.result.createObjectStore(CACHE_STORE, {keyPath: ['d', 't']});
+        if(!names.contains(CACHE_META)) r.result.createObjectStore(CACHE_META, {keyPath: 'd'});
+      };
+      cacheDb = await idbRequest(r);
+      deviceId = info.device;
+      const epochs = info.epochs || [];
+
+      // Points redatés depuis la visite précédente (table inconnue : tout) supprimés, nouvelle table
+      // enregistrée dans la même transaction
+      const meta = await idbRequest(cacheDb.transaction(CACHE_META).objectStore(CACHE_META).get(deviceId));
+      const from = meta ? redatedFrom(meta.epochs, epochs) : 0;
+      const tx = cacheDb.transaction([CACHE_STORE, CACHE_META], 'readwrite');
+      if(from < Infinity) tx.objectStore(CACHE_STORE).delete(deviceRange(from, Infinity));
+      tx.objectStore(CACHE_META).put({d: deviceId, epochs});
+      await new Promise((resolve, reject)=>{ tx.oncomplete = resolve; tx.onerror = ()=>reject(tx.error); });
+
+      // Appareil remis à zéro (journal effacé) : son dernier point précède le cache, qui ne se
+      // raccorde plus. Comparé après la purge : un point seulement redaté ne compte pas.
+      const last = await idbRequest(cacheDb.transaction(CACHE_STORE).objectStore(CACHE_STORE)
+        .openCursor(deviceRange(0, Infinity), 'prev'));
+      if(last && info.lastT && info.lastT < last.value.t) await cacheClear();
+    }catch(e){
+      console.warn('[CACHE] indisponible:', e);
+      cacheDb = null;
+    }
+  }
+
+  async function cacheClear(){
+    const tx = cacheDb.transaction(CACHE_STORE, 'readwrite');
+    tx.objectStore(CACHE_STORE).delete(deviceRange(0, Infinity));
+    await new Promise((resolve)=>{ tx.oncomplete = resolve; tx.onerror = resolve; });
+  }
+
+  // Cache -> store (les STORE_MAX plus récents) ; les plus anciens sont supprimés du cache
+  async function cacheLoad(){
+    const os = cacheDb.transaction(CACHE_STORE).objectStore(CACHE_STORE);
+    const rows = await idbRequest(os.getAll(deviceRange(0, Infinity)));
+    const first = Math.max(0, rows.length - STORE_MAX);
+    for(let i = first; i < rows.length; i++) storePush(rows[i].t, rows[i].v);
+    if(first > 0){
+      cacheDb.transaction(CACHE_STORE, 'readwrite').objectStore(CACHE_STORE).delete(deviceRange(0, rows[first].t));
+    }
+    return rows.length - first;
+  }
+
+  // Ajout sans attente (une transaction par lot)
+  function cachePut(samples){
+    if(!cacheDb || !samples.length) return;
+    const os = cacheDb.transaction(CACHE_STORE, 'readwrite').objectStore(CACHE_STORE);
+    for(const s of samples) os.put({d: deviceId, t: s.t, v: s.v});
+  }
+
+  // Points des colonnes décodées postérieurs à afterT, au format du cache
+  function cacheSamples(cols, afterT){
+    const out = [];
+    for(let i = 0; i < cols.n; i++){
+      if(cols.t[i] <= afterT) continue;
+      out.push({t: cols.t[i], v: Array.from(cols.ch, (col)=>col[i])});
+    }
+    return out;
+  }
+
+  // full=false (bouton recharger, historique brut) : seulement les points postérieurs au dernier connu.
+  // full=true en brut avec cache : store rechargé depuis le cache, puis même rattrapage incrémental.
+  // cache:'no-cache' : le navigateur revalide avec l'ETag, un 304 ne coûte que les en-têtes.
+  async function loadHistory(full){
+    status('', '');
+    try{
+      let cached = 0;
+      if(full === true && resolution === 'raw' && cacheDb){
+        storeClear();
+        cached = await cacheLoad();
+        if(cached){ scheduleFrame(); postLastCards(); }
+      }
+      const incremental = (full !== true || cached > 0) && resolution === 'raw' && store.len > 0;
+      const since = incremental ? `&since=${storeLastT()}` : '';
+      // Agrégats : tout le niveau, réduit côté ESP32 à ~1 point par pixel de largeur
+      const points = resolution !== 'raw' ? `&points=${Math.max(3, Math.min(500, px || 400))}` : '';
+      const r = await fetch(`${origin}/api/history?resolution=${resolution}&format=bin${since}${points}`, {cache:'no-cache'});
+      if(!r.ok) throw new Error('HTTP ' + r.status);
+      const cols = decodeHistoryBin(await r.arrayBuffer());
+      const end = Number(r.headers.get('X-History-End')) || 0;
+      if(resolution === 'raw' && end) lastSeq = incremental ? Math.max(lastSeq, end) : end;
+      if(!incremental) storeClear();
+      if(resolution === 'raw') cachePut(cacheSamples(cols, storeLastT()));
+      storeAppend(cols);
+      scheduleFrame();
+      postLastCards();
+      const label = resolution==='hour' ? 'Moyennes horaires' : resolution==='day' ? 'Moyennes journalières' : 'Historique RAM';
+      status(cached
+        ? `${label} : ${cached} points en cache + ${store.len - cached} nouveaux`
+        : `${label} chargé : ${store.len} points`);
+    }catch(e){
+      status(String(e), 'Échec /api/history');
+    }
+  }
+
+  // Échantillon SSE (texte JSON brut, id = séquence + 1) : cartes toujours, store seulement en brut.
+  // Doublons (rejeu, points déjà chargés par /api/history) reconnus à l'id, pas au temps :
+  // un échantillon daté avant le précédent (heure recalée) reste un nouvel échantillon.
+  function onSample(json, id){
+    const d = JSON.parse(json);
+    const v = sampleValues(d);
+    postCards(d.t, v);
+    if(resolution !== 'raw') return;  // Les agrégats ne suivent pas le live
+    if(id && lastSeq && id <= lastSeq) return;  // Déjà reçu
+    if(id) lastSeq = id;
+
+    storePush(d.t, v);  // O(1), le plus ancien est écrasé
+    cachePut([{t: d.t, v}]);
+    scheduleFrame();
+  }
+
+  onmessage = (e)=>{
+    const msg = e.data;
+    switch(msg.type){
+      case 'init':
+        origin = msg.origin;
+        px = msg.px || px;
+        rowCount = msg.rowCount || rowCount;
+        scheduleFrame();
+        break;
+      case 'start':
+        cacheOpen().then(()=>loadHistory(true));
+        break;
+      case 'px':
+        if(msg.px && msg.px !== px){ px = msg.px; scheduleFrame(); }
+        break;
+      case 'resolution':
+        resolution = msg.resolution;
+        loadHistory(true);
+        break;
+      case 'load':
+        if(msg.resync) lastSeq = 0;  // Journal repris (redémarrage, trou) : numérotation nouvelle
+        loadHistory(msg.full);
+        break;
+      case 'sample':
+        onSample(msg.json, msg.id);
+        break;
+      case 'rows':
+        rowFirst = msg.first;
+        postMessage(Object.assign({type: 'rows'}, tableWindow()));
+        break;
+    }
+  };
+</script>
+
 <script>
   // ========= DOM =========
   const dotConn  = document.getElementById('dotConn');
@@ -342,6 +781,7 @@ static const char INDEX_HTML[] = R"HTML(
   const tab3 = document.getElementById('tab3');
 
   const reloadBtn = document.getElementById('reload');
+  const resSel    = document.getElementById('resSel');
   const pauseBtn  = document.getElementById('pauseBtn');
   const csvBtn    = document.getElementById('csvBtn');
 
@@ -362,7 +802,6 @@ static const char INDEX_HTML[] = R"HTML(
   const canvasO2   = document.getElementById('plotO2');
   const ctxO2      = canvasO2.getContext('2d');
 
-  let history = [];
   let selected = 1;
   let paused = false;
   let lastMsgMs = 0;
@@ -371,6 +810,39 @@ static const char INDEX_HTML[] = R"HTML(
   let hoverIdxBac = null;
   let hoverIdxCmp = null;
 
+  // ========= Worker =========
+  // Données traitées par le worker (script dataWorker ci-dessus) ; ici, seulement le dessin.
+  // frame : dernière réduction reçue, indices de créneau 0..m-1 (voir postFrame)
+  const worker = new Worker(URL.createObjectURL(
+    new Blob([document.getElementById('dataWorker').textContent], {type: 'text/javascript'})));
+  let frame = null;
+
+  function frameT(i){ return frame.t[i]; }
+  function frameV(c, i){ return frame.v[c][i]; }
+  function frameRange(c){ return {lo: frame.rlo[c], hi: frame.rhi[c]}; }
+
+  // Largeur du tracé visible : nombre de créneaux utiles
+  function plotWidth(){
+    const canvas = (viewMode === 'bac') ? canvasBac : canvasTemp;
+    return Math.round(canvas.getBoundingClientRect().width);
+  }
+
+  worker.onmessage = (e)=>{
+    const msg = e.data;
+    if(msg.type === 'frame'){
+      frame = msg;
+      applyRows(msg.table);
+      redrawAll();
+    } else if(msg.type === 'rows'){
+      applyRows(msg);
+    } else if(msg.type === 'cards'){
+      updateCards(msg);
+    } else if(msg.type === 'status'){
+      errEl.textContent = msg.err;
+      hintEl.textContent = msg.hint;
+    }
+  };
+
   function nowLocal(){ return new Date().toLocaleTimeString(); }
   function formatTimestamp(t){
     if(!isFinite(t)) return '--';
@@ -388,42 +860,30 @@ static const char INDEX_HTML[] = R"HTML(
   }
 
   // ===== Badges simples =====
-  function rank(lvl){ return lvl==='bad'?2 : lvl==='warn'?1 : lvl==='ok'?0 : -1; }
-  function worstOf(levels){
-    const xs = levels.filter(x=>x);
-    if(xs.length===0) return null;
-    return xs.sort((a,b)=>rank(b)-rank(a))[0];
-  }
-  function evalTemp(t){ if(!isFinite(t)) return {lvl:null}; if(t>=65) return {lvl:'bad'}; if(t>=55) return {lvl:'warn'}; return {lvl:'ok'}; }
-  function evalHum(h){ if(!isFinite(h)) return {lvl:null}; if(h<=35||h>=85) return {lvl:'bad'}; if(h<=45||h>=75) return {lvl:'warn'}; return {lvl:'ok'}; }
-  function evalO2(o){ if(!isFinite(o)) return {lvl:null}; if(o<=18.5) return {lvl:'bad'}; if(o<=19.5) return {lvl:'warn'}; return {lvl:'ok'}; }
+  // Niveaux calculés par le worker (message cards)
   function stateBadge(elBadge, elText, lvl){
     elText.textContent = lvl==='bad'?'ALERTE':lvl==='warn'?'WARNING':lvl==='ok'?'OK':'—';
     elBadge.classList.remove('ok','warn','bad');
     if(lvl) elBadge.classList.add(lvl);
   }
 
+  // d : {t, v: valeurs dans l'ordre des canaux, lvl: niveau de chaque bac}
   function updateCards(d){
     elTs.textContent = formatTimestamp(d.t);
+    const v = d.v;
 
-    const b1 = d.b1 || {};
-    const b1t = Number(b1.tempC), b1h = Number(b1.humPct), b1o = Number(b1.o2Pct);
-    b1Temp.textContent = isFinite(b1t)? b1t.toFixed(2) : '--';
-    b1Hum.textContent  = isFinite(b1h)? b1h.toFixed(2) : '--';
-    b1O2.textContent   = isFinite(b1o)? b1o.toFixed(2) : '--';
-    stateBadge(b1Badge, b1State, worstOf([evalTemp(b1t).lvl, evalHum(b1h).lvl, evalO2(b1o).lvl]));
+    b1Temp.textContent = fmt2(v[0]);
+    b1Hum.textContent  = fmt2(v[1]);
+    b1O2.textContent   = fmt2(v[2]);
+    stateBadge(b1Badge, b1State, d.lvl[0]);
 
-    const b2 = d.b3 || {};
-    const b2t = Number(b2.tempC), b2h = Number(b2.humPct);
-    b2Temp.textContent = isFinite(b2t)? b2t.toFixed(2) : '--';
-    b2Hum.textContent  = isFinite(b2h)? b2h.toFixed(2) : '--';
-    stateBadge(b2Badge, b2State, worstOf([evalTemp(b2t).lvl, evalHum(b2h).lvl]));
+    b2Temp.textContent = fmt2(v[5]);
+    b2Hum.textContent  = fmt2(v[6]);
+    stateBadge(b2Badge, b2State, d.lvl[2]);
 
-    const b3 = d.b2 || {};
-    const b3t = Number(b3.tempC), b3h = Number(b3.humPct);
-    b3Temp.textContent = isFinite(b3t)? b3t.toFixed(2) : '--';
-    b3Hum.textContent  = isFinite(b3h)? b3h.toFixed(2) : '--';
-    stateBadge(b3Badge, b3State, worstOf([evalTemp(b3t).lvl, evalHum(b3h).lvl]));
+    b3Temp.textContent = fmt2(v[3]);
+    b3Hum.textContent  = fmt2(v[4]);
+    stateBadge(b3Badge, b3State, d.lvl[1]);
   }
 
   // ========= View mode =========
@@ -439,13 +899,12 @@ static const char INDEX_HTML[] = R"HTML(
     viewDesc.textContent = (mode==='bac') ? 'Vue Bac (détails)' : 'Comparaison des bacs';
     hoverIdxBac = null;
     hoverIdxCmp = null;
+    worker.postMessage({type: 'px', px: plotWidth()});
     redrawAll();
-    if (history.length) updateCards(history[history.length - 1]);
 
   }
   viewBacBtn.addEventListener('click', ()=>setViewMode('bac'));
   viewCmpBtn.addEventListener('click', ()=>setViewMode('cmp'));
-
   // ========= Bac selection =========
   function setSelected(n){
     selected = n;
@@ -480,10 +939,11 @@ static const char INDEX_HTML[] = R"HTML(
     }
   }
 
-  function minMax(arr){
-    const fin = arr.filter(v => Number.isFinite(v));
-    if(fin.length === 0) return {lo:0, hi:1};
-    let lo = Math.min(...fin), hi = Math.max(...fin);
+  // Échelle d'une liste de plages {lo, hi} : {0,1} si aucune valeur, +1 si plate
+  function rangeOf(ranges){
+    let lo = Infinity, hi = -Infinity;
+    for(const r of ranges){ if(r.lo < lo) lo = r.lo; if(r.hi > hi) hi = r.hi; }
+    if(!(lo <= hi)) return {lo:0, hi:1};
     if(Math.abs(hi-lo) < 1e-9){ hi = lo + 1; }
     return {lo, hi};
   }
@@ -524,8 +984,7 @@ static const char INDEX_HTML[] = R"HTML(
     return {PW, PH};
   }
 
-  function drawTicksX(ctx, dpr, L, T, PH, PW, times){
-    const n = times.length;
+  function drawTicksX(ctx, dpr, L, T, PH, PW, n){
     if(n < 2) return;
 
     const gridX = 6;
@@ -537,17 +996,19 @@ static const char INDEX_HTML[] = R"HTML(
     ctx.textBaseline = 'top';
     for(let i=0;i<=gridX;i++){
       const idx = Math.round((n-1) * (i/gridX));
-      ctx.fillText(String(times[idx]), xOfIdx(idx), T+PH + Math.floor(8*dpr));
+      ctx.fillText(String(frameT(idx)), xOfIdx(idx), T+PH + Math.floor(8*dpr));
     }
     ctx.textAlign = 'left';
     ctx.fillText('t (s)', L, T+PH + Math.floor(26*dpr));
   }
 
-  function drawLine(ctx, dpr, L, T, PW, PH, arr, vMin, vMax, stroke, width, dashed){
-    const n = arr.length;
+  // Courbe du canal c de la frame : un point par créneau, plus un trait vertical min -> max
+  // quand le créneau regroupe des valeurs différentes
+  function drawLine(ctx, dpr, L, T, PW, PH, c, vMin, vMax, stroke, width, dashed){
+    const n = frame ? frame.m : 0;
     if(n < 2) return;
-    const xOfIdx = (i)=> L + (PW * (i/(n-1)));
-    const yOf = (v)=> T + PH * (1 - (v - vMin) / (vMax - vMin));
+    const col = frame.v[c], lo = frame.lo[c], hi = frame.hi[c];
+    const sx = PW / (n-1), sy = PH / (vMax - vMin);
 
     ctx.save();
     ctx.strokeStyle = stroke;
@@ -555,21 +1016,25 @@ static const char INDEX_HTML[] = R"HTML(
     ctx.setLineDash(dashed ? [Math.floor(6*dpr), Math.floor(5*dpr)] : []);
     ctx.beginPath();
     let started = false;
-    for(let i=0;i<n;i++){
-      const v = arr[i];
-      if(!Number.isFinite(v)) continue;
-      const x = xOfIdx(i);
-      const y = yOf(v);
+    const to = (x, v)=>{
+      const y = T + PH - (v - vMin) * sy;
       if(!started){ ctx.moveTo(x,y); started=true; } else ctx.lineTo(x,y);
+    };
+    for(let i=0; i<n; i++){
+      const v = col[i], l = lo[i], h = hi[i];
+      if(!(l <= h)) continue;  // Créneau sans valeur
+      const x = L + sx * i;
+      if(l < h){ to(x, l); to(x, h); }
+      to(x, v === v ? v : h);
     }
     ctx.stroke();
     ctx.restore();
   }
 
-  function drawMarker(ctx, dpr, L, T, PW, PH, i, arr, vMin, vMax, fill){
-    const n = arr.length;
+  function drawMarker(ctx, dpr, L, T, PW, PH, i, c, vMin, vMax, fill){
+    const n = frame ? frame.m : 0;
     if(n < 2) return;
-    const v = arr[i];
+    const v = frameV(c, i);
     if(!Number.isFinite(v)) return;
     const x = L + (PW * (i/(n-1)));
     const y = T + PH * (1 - (v - vMin) / (vMax - vMin));
@@ -610,209 +1075,212 @@ static const char INDEX_HTML[] = R"HTML(
     }
   }
 
-  // ========= Séries =========
-  function seriesBac(bac){
-    const key = 'b'+bac;
-    return {
-      t: history.map(p=>p.t),
-      temp: history.map(p=>Number((p[key]||{}).tempC)),
-      hum:  history.map(p=>Number((p[key]||{}).humPct)),
-      o2:   history.map(p=>Number((p[key]||{}).o2Pct))
-    };
+  function drawCrosshair(ctx, dpr, T, PH, x){
+    ctx.strokeStyle = 'rgba(255,255,255,0.35)';
+    ctx.lineWidth = Math.floor(1.2*dpr);
+    ctx.setLineDash([Math.floor(4*dpr), Math.floor(4*dpr)]);
+    ctx.beginPath(); ctx.moveTo(x, T); ctx.lineTo(x, T+PH); ctx.stroke();
+    ctx.setLineDash([]);
   }
 
-  // ========= Vue Bac =========
-  function redrawBac(){
-    resizeCanvasToDisplaySize(canvasBac);
-    const w = canvasBac.width, h = canvasBac.height;
-    const dpr = window.devicePixelRatio || 1;
-
-    const L = Math.floor(52 * dpr), R = Math.floor(16 * dpr), T = Math.floor(16 * dpr), B = Math.floor(40 * dpr);
-
-    ctxBac.clearRect(0,0,w,h);
-    const {PW, PH} = drawGridAxes(ctxBac, w, h, L, R, T, B);
-
-    if(history.length < 2){
-      ctxBac.fillStyle = 'rgba(255,255,255,0.55)';
-      ctxBac.font = `${Math.floor(12*dpr)}px system-ui`;
-      ctxBac.fillText('En attente de données…', L + Math.floor(10*dpr), T + Math.floor(20*dpr));
-      return;
-    }
-
-    const S = seriesBac(selected);
-    const n = S.t.length;
-
-    const rT = minMax(S.temp);
-    const rH = minMax(S.hum);
-    const rO = minMax(S.o2);
-
-    drawTicksX(ctxBac, dpr, L, T, PH, PW, S.t);
-
-    const colTemp = 'rgba(251,113,133,0.95)';
-    const colHum  = 'rgba(96,165,250,0.95)';
-    const colO2   = 'rgba(167,139,250,0.95)';
-
-    drawLine(ctxBac, dpr, L, T, PW, PH, S.temp, rT.lo-0.5, rT.hi+0.5, colTemp, Math.floor(2.4*dpr), false);
-    drawLine(ctxBac, dpr, L, T, PW, PH, S.hum,  rH.lo-1,   rH.hi+1,   colHum,  Math.floor(2.0*dpr), false);
-    if(selected===1){
-      drawLine(ctxBac, dpr, L, T, PW, PH, S.o2,  rO.lo-0.1, rO.hi+0.1, colO2,   Math.floor(1.8*dpr), true);
-    }
-
-    const lastI = n-1;
-    drawMarker(ctxBac, dpr, L, T, PW, PH, lastI, S.temp, rT.lo-0.5, rT.hi+0.5, colTemp);
-    drawMarker(ctxBac, dpr, L, T, PW, PH, lastI, S.hum,  rH.lo-1,   rH.hi+1,   colHum);
-    if(selected===1) drawMarker(ctxBac, dpr, L, T, PW, PH, lastI, S.o2, rO.lo-0.1, rO.hi+0.1, colO2);
-
-    if(hoverIdxBac !== null){
-      const i = Math.max(0, Math.min(n-1, hoverIdxBac));
-      const x = L + (PW * (i/(n-1)));
-
-      ctxBac.strokeStyle = 'rgba(255,255,255,0.35)';
-      ctxBac.lineWidth = Math.floor(1.2*dpr);
-      ctxBac.setLineDash([Math.floor(4*dpr), Math.floor(4*dpr)]);
-      ctxBac.beginPath(); ctxBac.moveTo(x, T); ctxBac.lineTo(x, T+PH); ctxBac.stroke();
-      ctxBac.setLineDash([]);
-
-      drawMarker(ctxBac, dpr, L, T, PW, PH, i, S.temp, rT.lo-0.5, rT.hi+0.5, colTemp);
-      drawMarker(ctxBac, dpr, L, T, PW, PH, i, S.hum,  rH.lo-1,   rH.hi+1,   colHum);
-      if(selected===1) drawMarker(ctxBac, dpr, L, T, PW, PH, i, S.o2, rO.lo-0.1, rO.hi+0.1, colO2);
-
-      const tt = S.t[i];
-      const vT = S.temp[i], vH = S.hum[i], vO = S.o2[i];
-      const lines = (selected===1)
-        ? [`${formatTimestampShort(tt)}`, `Temp: ${Number.isFinite(vT)?vT.toFixed(2):'--'} °C`, `Hum: ${Number.isFinite(vH)?vH.toFixed(2):'--'} %`, `O₂: ${Number.isFinite(vO)?vO.toFixed(2):'--'} %`]
-        : [`${formatTimestampShort(tt)}`, `Temp: ${Number.isFinite(vT)?vT.toFixed(2):'--'} °C`, `Hum: ${Number.isFinite(vH)?vH.toFixed(2):'--'} %`];
-
-      drawTooltip(ctxBac, dpr, L, T, PW, PH, x, T+Math.floor(12*dpr), lines);
-    }
+  // ========= Calques =========
+  // Le tracé statique (grille, courbes, derniers points) est rendu une fois dans un canvas hors écran,
+  // tant que frame, sélection et taille ne changent pas ; un survol ne fait que le recopier
+  // et redessiner le curseur, les marqueurs et l'info-bulle.
+  function makeLayer(canvas){
+    return {canvas, ctx: canvas.getContext('2d'), base: document.createElement('canvas'), key: '', g: null};
+  }
 
-    if(history.length){
-      const last = history[history.length-1];
-      const b = last['b'+selected] || {};
-      const t = Number(b.tempC), h = Number(b.humPct), o = Number(b.o2Pct);
-      liveVals.textContent = (selected===1)
-        ? `Temp: ${Number.isFinite(t)?t.toFixed(2):'--'} °C • Hum: ${Number.isFinite(h)?h.toFixed(2):'--'} % • O₂: ${Number.isFinite(o)?o.toFixed(2):'--'} %`
-        : `Temp: ${Number.isFinite(t)?t.toFixed(2):'--'} °C • Hum: ${Number.isFinite(h)?h.toFixed(2):'--'} %`;
+  // drawBase(ctx, w, h) -> géométrie pour le survol (null si pas de données) ; drawOverlay(ctx, g)
+  function renderLayer(layer, key, drawBase, drawOverlay){
+    resizeCanvasToDisplaySize(layer.canvas);
+    const w = layer.canvas.width, h = layer.canvas.height;
+    const fullKey = `${key}|${frame ? frame.seq : 0}|${w}x${h}`;
+    if(layer.key !== fullKey){
+      layer.base.width = w;
+      layer.base.height = h;
+      const bctx = layer.base.getContext('2d');
+      bctx.clearRect(0,0,w,h);
+      layer.g = drawBase(bctx, w, h);
+      layer.key = fullKey;
     }
+    layer.ctx.clearRect(0,0,w,h);
+    layer.ctx.drawImage(layer.base, 0, 0);
+    if(layer.g && drawOverlay) drawOverlay(layer.ctx, layer.g);
   }
 
-  // ========= Comparaison =========
-  function redrawCompareOne(canvas, ctx, title, field){
-    resizeCanvasToDisplaySize(canvas);
-    const w = canvas.width, h = canvas.height;
+  // Grille + message d'attente ; géométrie commune sinon
+  function baseFrame(ctx, w, h){
     const dpr = window.devicePixelRatio || 1;
-
     const L = Math.floor(52 * dpr), R = Math.floor(16 * dpr), T = Math.floor(16 * dpr), B = Math.floor(40 * dpr);
-
-    ctx.clearRect(0,0,w,h);
     const {PW, PH} = drawGridAxes(ctx, w, h, L, R, T, B);
-
-    if(history.length < 2){
+    const n = frame ? frame.m : 0;
+    if(n < 2){
       ctx.fillStyle = 'rgba(255,255,255,0.55)';
       ctx.font = `${Math.floor(12*dpr)}px system-ui`;
       ctx.fillText('En attente de données…', L + Math.floor(10*dpr), T + Math.floor(20*dpr));
-      return;
+      return null;
     }
+    drawTicksX(ctx, dpr, L, T, PH, PW, n);
+    return {dpr, L, T, PW, PH, n};
+  }
 
-    const times = history.map(p=>p.t);
-    const b1 = history.map(p=>Number((p.b1||{})[field]));
-    const b2 = history.map(p=>Number((p.b2||{})[field]));
-    const b3 = history.map(p=>Number((p.b3||{})[field]));
-
-    const all = b1.concat(b2).concat(b3);
-    const r = minMax(all);
+  const layerBac  = makeLayer(canvasBac);
+  const layerTemp = makeLayer(canvasTemp);
+  const layerHum  = makeLayer(canvasHum);
+  const layerO2   = makeLayer(canvasO2);
 
-    drawTicksX(ctx, dpr, L, T, PH, PW, times);
+  // ========= Séries =========
+  // Canaux (ordre BIN_KEYS du worker) de chaque bac ; -1 = absent
+  const BAC_CH = {1:{temp:0, hum:1, o2:2}, 2:{temp:3, hum:4, o2:-1}, 3:{temp:5, hum:6, o2:-1}};
+  const CMP_CH = {tempC:[0,3,5], humPct:[1,4,6]};
+  const fmt2 = (v)=> Number.isFinite(v) ? v.toFixed(2) : '--';
 
-    const colB1 = 'rgba(251,113,133,0.95)';
-    const colB2 = 'rgba(96,165,250,0.95)';
-    const colB3 = 'rgba(52,211,153,0.95)';
+  // ========= Vue Bac =========
+  const colTemp = 'rgba(251,113,133,0.95)';
+  const colHum  = 'rgba(96,165,250,0.95)';
+  const colO2   = 'rgba(167,139,250,0.95)';
+
+  function drawBacBase(ctx, w, h){
+    const g = baseFrame(ctx, w, h);
+    if(!g) return null;
+    const {dpr, L, T, PW, PH, n} = g;
+    const C = BAC_CH[selected];
+
+    const rT = rangeOf([frameRange(C.temp)]);
+    const rH = rangeOf([frameRange(C.hum)]);
+    const rO = C.o2 >= 0 ? rangeOf([frameRange(C.o2)]) : {lo:0, hi:1};
+    g.sT = [rT.lo-0.5, rT.hi+0.5];
+    g.sH = [rH.lo-1, rH.hi+1];
+    g.sO = [rO.lo-0.1, rO.hi+0.1];
+
+    drawLine(ctx, dpr, L, T, PW, PH, C.temp, g.sT[0], g.sT[1], colTemp, Math.floor(2.4*dpr), false);
+    drawLine(ctx, dpr, L, T, PW, PH, C.hum,  g.sH[0], g.sH[1], colHum,  Math.floor(2.0*dpr), false);
+    if(selected===1){
+      drawLine(ctx, dpr, L, T, PW, PH, C.o2, g.sO[0], g.sO[1], colO2, Math.floor(1.8*dpr), true);
+    }
 
-    drawLine(ctx, dpr, L, T, PW, PH, b1, r.lo, r.hi, colB1, Math.floor(2.2*dpr), false);
-    drawLine(ctx, dpr, L, T, PW, PH, b2, r.lo, r.hi, colB2, Math.floor(2.2*dpr), false);
-    drawLine(ctx, dpr, L, T, PW, PH, b3, r.lo, r.hi, colB3, Math.floor(2.2*dpr), false);
+    const lastI = n-1;
+    drawMarker(ctx, dpr, L, T, PW, PH, lastI, C.temp, g.sT[0], g.sT[1], colTemp);
+    drawMarker(ctx, dpr, L, T, PW, PH, lastI, C.hum,  g.sH[0], g.sH[1], colHum);
+    if(selected===1) drawMarker(ctx, dpr, L, T, PW, PH, lastI, C.o2, g.sO[0], g.sO[1], colO2);
+
+    const t = frameV(C.temp, lastI), hm = frameV(C.hum, lastI);
+    liveVals.textContent = (selected===1)
+      ? `Temp: ${fmt2(t)} °C • Hum: ${fmt2(hm)} % • O₂: ${fmt2(frameV(C.o2, lastI))} %`
+      : `Temp: ${fmt2(t)} °C • Hum: ${fmt2(hm)} %`;
+    return g;
+  }
 
-    const lastI = times.length-1;
-    drawMarker(ctx, dpr, L, T, PW, PH, lastI, b1, r.lo, r.hi, colB1);
-    drawMarker(ctx, dpr, L, T, PW, PH, lastI, b2, r.lo, r.hi, colB2);
-    drawMarker(ctx, dpr, L, T, PW, PH, lastI, b3, r.lo, r.hi, colB3);
+  function drawBacOverlay(ctx, g){
+    if(hoverIdxBac === null) return;
+    const {dpr, L, T, PW, PH, n} = g;
+    const C = BAC_CH[selected];
+    const i = Math.max(0, Math.min(n-1, hoverIdxBac));
+    const x = L + (PW * (i/(n-1)));
 
-    ctx.fillStyle = 'rgba(255,255,255,0.55)';
-    ctx.font = `${Math.floor(11*dpr)}px system-ui`;
-    ctx.fillText(title, L, T + Math.floor(14*dpr));
+    drawCrosshair(ctx, dpr, T, PH, x);
+    drawMarker(ctx, dpr, L, T, PW, PH, i, C.temp, g.sT[0], g.sT[1], colTemp);
+    drawMarker(ctx, dpr, L, T, PW, PH, i, C.hum,  g.sH[0], g.sH[1], colHum);
+    if(selected===1) drawMarker(ctx, dpr, L, T, PW, PH, i, C.o2, g.sO[0], g.sO[1], colO2);
 
-    if(hoverIdxCmp !== null){
-      const n = times.length;
-      const i = Math.max(0, Math.min(n-1, hoverIdxCmp));
-      const x = L + (PW * (i/(n-1)));
+    const tt = frameT(i);
+    const vT = frameV(C.temp, i), vH = frameV(C.hum, i);
+    const lines = (selected===1)
+      ? [`${formatTimestampShort(tt)}`, `Temp: ${fmt2(vT)} °C`, `Hum: ${fmt2(vH)} %`, `O₂: ${fmt2(frameV(C.o2, i))} %`]
+      : [`${formatTimestampShort(tt)}`, `Temp: ${fmt2(vT)} °C`, `Hum: ${fmt2(vH)} %`];
 
-      ctx.strokeStyle = 'rgba(255,255,255,0.35)';
-      ctx.lineWidth = Math.floor(1.2*dpr);
-      ctx.setLineDash([Math.floor(4*dpr), Math.floor(4*dpr)]);
-      ctx.beginPath(); ctx.moveTo(x, T); ctx.lineTo(x, T+PH); ctx.stroke();
-      ctx.setLineDash([]);
-
-      drawMarker(ctx, dpr, L, T, PW, PH, i, b1, r.lo, r.hi, colB1);
-      drawMarker(ctx, dpr, L, T, PW, PH, i, b2, r.lo, r.hi, colB2);
-      drawMarker(ctx, dpr, L, T, PW, PH, i, b3, r.lo, r.hi, colB3);
-
-      const tt = times[i];
-      const v1 = b1[i], v2 = b2[i], v3 = b3[i];
-      const suffix = (field==='tempC') ? '°C' : '%';
-      const lines = [
-        `${formatTimestampShort(tt)}`,
-        `Bac 1: ${Number.isFinite(v1)?v1.toFixed(2):'--'} ${suffix}`,
-        `Bac 2: ${Number.isFinite(v2)?v2.toFixed(2):'--'} ${suffix}`,
-        `Bac 3: ${Number.isFinite(v3)?v3.toFixed(2):'--'} ${suffix}`,
-      ];
-
-      drawTooltip(ctx, dpr, L, T, PW, PH, x, T+Math.floor(12*dpr), lines);
-      cmpVals.textContent = `${title} @ t=${tt}s  →  B1:${Number.isFinite(v1)?v1.toFixed(2):'--'}  B2:${Number.isFinite(v2)?v2.toFixed(2):'--'}  B3:${Number.isFinite(v3)?v3.toFixed(2):'--'}`;
-    } else {
-      const n = times.length;
-      const v1 = b1[n-1], v2 = b2[n-1], v3 = b3[n-1];
-      cmpVals.textContent = `${title} (dernier)  →  B1:${Number.isFinite(v1)?v1.toFixed(2):'--'}  B2:${Number.isFinite(v2)?v2.toFixed(2):'--'}  B3:${Number.isFinite(v3)?v3.toFixed(2):'--'}`;
-    }
+    drawTooltip(ctx, dpr, L, T, PW, PH, x, T+Math.floor(12*dpr), lines);
   }
 
-  function redrawO2(canvas, ctx){
-    resizeCanvasToDisplaySize(canvas);
-    const w = canvas.width, h = canvas.height;
-    const dpr = window.devicePixelRatio || 1;
-
-    const L = Math.floor(52 * dpr), R = Math.floor(16 * dpr), T = Math.floor(16 * dpr), B = Math.floor(40 * dpr);
+  function redrawBac(){
+    renderLayer(layerBac, `bac${selected}`, drawBacBase, drawBacOverlay);
+  }
 
-    ctx.clearRect(0,0,w,h);
-    const {PW, PH} = drawGridAxes(ctx, w, h, L, R, T, B);
+  // ========= Comparaison =========
+  const colB1 = 'rgba(251,113,133,0.95)';
+  const colB2 = 'rgba(96,165,250,0.95)';
+  const colB3 = 'rgba(52,211,153,0.95)';
+
+  function drawCompareBase(title, field){
+    return (ctx, w, h)=>{
+      const g = baseFrame(ctx, w, h);
+      if(!g) return null;
+      const {dpr, L, T, PW, PH, n} = g;
+      const [c1, c2, c3] = CMP_CH[field];
+      const r = rangeOf([frameRange(c1), frameRange(c2), frameRange(c3)]);
+      g.r = r;
+
+      drawLine(ctx, dpr, L, T, PW, PH, c1, r.lo, r.hi, colB1, Math.floor(2.2*dpr), false);
+      drawLine(ctx, dpr, L, T, PW, PH, c2, r.lo, r.hi, colB2, Math.floor(2.2*dpr), false);
+      drawLine(ctx, dpr, L, T, PW, PH, c3, r.lo, r.hi, colB3, Math.floor(2.2*dpr), false);
+
+      const lastI = n-1;
+      drawMarker(ctx, dpr, L, T, PW, PH, lastI, c1, r.lo, r.hi, colB1);
+      drawMarker(ctx, dpr, L, T, PW, PH, lastI, c2, r.lo, r.hi, colB2);
+      drawMarker(ctx, dpr, L, T, PW, PH, lastI, c3, r.lo, r.hi, colB3);
 
-    if(history.length < 2){
       ctx.fillStyle = 'rgba(255,255,255,0.55)';
-      ctx.font = `${Math.floor(12*dpr)}px system-ui`;
-      ctx.fillText('En attente de données…', L + Math.floor(10*dpr), T + Math.floor(20*dpr));
-      return;
-    }
-
-    const times = history.map(p=>p.t);
-    const o2 = history.map(p=>Number((p.b1||{}).o2Pct));
-    const r = minMax(o2);
+      ctx.font = `${Math.floor(11*dpr)}px system-ui`;
+      ctx.fillText(title, L, T + Math.floor(14*dpr));
+      return g;
+    };
+  }
 
-    drawTicksX(ctx, dpr, L, T, PH, PW, times);
+  function drawCompareOverlay(title, field){
+    return (ctx, g)=>{
+      const {dpr, L, T, PW, PH, n, r} = g;
+      const [c1, c2, c3] = CMP_CH[field];
+      if(hoverIdxCmp !== null){
+        const i = Math.max(0, Math.min(n-1, hoverIdxCmp));
+        const x = L + (PW * (i/(n-1)));
+
+        drawCrosshair(ctx, dpr, T, PH, x);
+        drawMarker(ctx, dpr, L, T, PW, PH, i, c1, r.lo, r.hi, colB1);
+        drawMarker(ctx, dpr, L, T, PW, PH, i, c2, r.lo, r.hi, colB2);
+        drawMarker(ctx, dpr, L, T, PW, PH, i, c3, r.lo, r.hi, colB3);
+
+        const tt = frameT(i);
+        const v1 = frameV(c1, i), v2 = frameV(c2, i), v3 = frameV(c3, i);
+        const suffix = (field==='tempC') ? '°C' : '%';
+        const lines = [
+          `${formatTimestampShort(tt)}`,
+          `Bac 1: ${fmt2(v1)} ${suffix}`,
+          `Bac 2: ${fmt2(v2)} ${suffix}`,
+          `Bac 3: ${fmt2(v3)} ${suffix}`,
+        ];
+
+        drawTooltip(ctx, dpr, L, T, PW, PH, x, T+Math.floor(12*dpr), lines);
+        cmpVals.textContent = `${title} @ t=${tt}s  →  B1:${fmt2(v1)}  B2:${fmt2(v2)}  B3:${fmt2(v3)}`;
+      } else {
+        const i = n-1;
+        cmpVals.textContent = `${title} (dernier)  →  B1:${fmt2(frameV(c1, i))}  B2:${fmt2(frameV(c2, i))}  B3:${fmt2(frameV(c3, i))}`;
+      }
+    };
+  }
 
-    const col = 'rgba(167,139,250,0.95)';
-    drawLine(ctx, dpr, L, T, PW, PH, o2, r.lo-0.1, r.hi+0.1, col, Math.floor(2.1*dpr), true);
+  function drawO2Base(ctx, w, h){
+    const g = baseFrame(ctx, w, h);
+    if(!g) return null;
+    const {dpr, L, T, PW, PH, n} = g;
+    const r = rangeOf([frameRange(2)]);
 
-    const lastI = times.length-1;
-    drawMarker(ctx, dpr, L, T, PW, PH, lastI, o2, r.lo-0.1, r.hi+0.1, col);
+    drawLine(ctx, dpr, L, T, PW, PH, 2, r.lo-0.1, r.hi+0.1, colO2, Math.floor(2.1*dpr), true);
+    drawMarker(ctx, dpr, L, T, PW, PH, n-1, 2, r.lo-0.1, r.hi+0.1, colO2);
 
     ctx.fillStyle = 'rgba(255,255,255,0.55)';
     ctx.font = `${Math.floor(11*dpr)}px system-ui`;
     ctx.fillText('O₂ (Bac 1) %', L, T + Math.floor(14*dpr));
+    return g;
   }
 
+  const cmpTemp = [drawCompareBase('Temp (°C)', 'tempC'), drawCompareOverlay('Temp (°C)', 'tempC')];
+  const cmpHum  = [drawCompareBase('Hum (%)', 'humPct'), drawCompareOverlay('Hum (%)', 'humPct')];
+
   function redrawCompare(){
-    redrawCompareOne(canvasTemp, ctxTemp, 'Temp (°C)', 'tempC');
-    redrawCompareOne(canvasHum,  ctxHum,  'Hum (%)',   'humPct');
-    redrawO2(canvasO2, ctxO2);
+    renderLayer(layerTemp, 'tempC', cmpTemp[0], cmpTemp[1]);
+    renderLayer(layerHum,  'humPct', cmpHum[0], cmpHum[1]);
+    renderLayer(layerO2,   'o2', drawO2Base, null);
   }
 
   function redrawAll(){
@@ -821,42 +1289,105 @@ static const char INDEX_HTML[] = R"HTML(
   }
 
   // ========= Table =========
-  function refreshTable(){
-    const last = history.slice(-10).reverse();
-    tbody.innerHTML = last.map(p => {
-      const b = p['b'+selected] || {};
-      const t = formatTimestamp(p.t);
-      const temp = Number(b.tempC);
-      const hum  = Number(b.humPct);
-      const o2   = Number(b.o2Pct);
-      const o2Txt = (selected===1 && Number.isFinite(o2)) ? o2.toFixed(2) : '—';
-      return `<tr>
-        <td>${t}</td>
-        <td>${Number.isFinite(temp)? temp.toFixed(2) : '—'}</td>
-        <td>${Number.isFinite(hum)? hum.toFixed(2) : '—'}</td>
-        <td>${o2Txt}</td>
-      </tr>`;
-    }).join("");
-  }
-
-  async function loadHistory(){
-    errEl.textContent = '';
-    hintEl.textContent = '';
-    try{
-      const r = await fetch('/api/history', {cache:'no-store'});
-      if(!r.ok) throw new Error('HTTP ' + r.status);
-      history = await r.json();
-      refreshTable();
-      redrawAll();
-      if (history.length) updateCards(history[history.length - 1]);
-      hintEl.textContent = `Historique RAM chargé : ${history.length} points`;
-    }catch(e){
-      errEl.textContent = 'Échec /api/history';
-      hintEl.textContent = String(e);
+  // Historique complet, plus récent en tête, virtualisé : seules TABLE_POOL lignes existent dans le
+  // DOM (fenêtre [first, first + TABLE_POOL) fournie par le worker), entre deux lignes d'espacement
+  // qui donnent sa hauteur à la zone de défilement. Les lignes sont repérées par leur t : un nouvel
+  // échantillon recycle la plus ancienne en tête (un déplacement, 4 cellules), jamais de innerHTML.
+  const ROW_H = 34;       // = hauteur CSS de .tableScroll tbody tr
+  const TABLE_POOL = 24;  // ~10 lignes visibles + marge de défilement
+  const tableScroll = document.getElementById('tableScroll');
+  const table = {len: 0, first: 0, gen: -1, want: 0};
+  const pool = [];  // {tr, td: [4], t} dans l'ordre d'affichage ; t = null si libre
+
+  function tablePad(){
+    const tr = document.createElement('tr');
+    const td = document.createElement('td');
+    td.colSpan = 4;
+    tr.className = 'pad';
+    tr.appendChild(td);
+    return tr;
+  }
+  const padTop = tbody.appendChild(tablePad());
+  for(let i = 0; i < TABLE_POOL; i++){
+    const tr = document.createElement('tr');
+    const td = [0, 1, 2, 3].map(()=>tr.appendChild(document.createElement('td')));
+    tr.style.display = 'none';
+    pool.push({tr: tbody.appendChild(tr), td, t: null});
+  }
+  const padBottom = tbody.appendChild(tablePad());
+
+  function cellText(v){ return Number.isFinite(v)? v.toFixed(2) : '—'; }
+  function fillRow(e, row){
+    const C = BAC_CH[selected];
+    e.t = row[0];
+    e.row = row;
+    e.td[0].textContent = formatTimestamp(row[0]);
+    e.td[1].textContent = cellText(row[1 + C.temp]);
+    e.td[2].textContent = cellText(row[1 + C.hum]);
+    e.td[3].textContent = cellText(C.o2 >= 0 ? row[1 + C.o2] : NaN);
+    e.tr.style.display = '';
+  }
+
+  // Fenêtre {len, first, gen, rows} du worker : lignes déjà affichées conservées (même t),
+  // les autres remplies dans les entrées libérées, puis ordre du DOM corrigé par déplacements
+  function applyRows(w){
+    const byT = new Map();
+    if(w.gen === table.gen) for(const e of pool) if(e.t !== null) byT.set(e.t, e);
+    const prevTop = (table.first === w.first && pool[0].t !== null) ? pool[0].t : null;
+
+    const next = w.rows.map((row)=>{
+      const e = byT.get(row[0]);
+      if(e) byT.delete(row[0]);
+      return e || null;
+    });
+    const spare = pool.filter((e)=>!next.includes(e));
+    next.forEach((e, k)=>{ if(!e) fillRow(next[k] = spare.shift(), w.rows[k]); });
+    for(const e of spare){
+      e.t = null;
+      e.tr.style.display = 'none';
     }
+
+    let ref = padTop.nextSibling;
+    for(const e of next){
+      if(e.tr !== ref) tbody.insertBefore(e.tr, ref);
+      else ref = ref.nextSibling;
+    }
+    pool.splice(0, pool.length, ...next, ...spare);
+
+    padTop.style.height = `${w.first * ROW_H}px`;
+    padBottom.style.height = `${Math.max(0, w.len - w.first - w.rows.length) * ROW_H}px`;
+    // Nouvelles lignes au-dessus d'une vue défilée : elle reste sur les mêmes mesures
+    const added = prevTop === null ? -1 : w.rows.findIndex((row)=>row[0] === prevTop);
+    if(added > 0 && tableScroll.scrollTop > 0) tableScroll.scrollTop += added * ROW_H;
+    table.len = w.len;
+    table.first = w.first;
+    table.gen = w.gen;
+  }
+
+  // Changement de bac : mêmes lignes, autres colonnes
+  function refreshTable(){
+    for(const e of pool) if(e.t !== null) fillRow(e, e.row);
   }
 
-  reloadBtn.addEventListener('click', loadHistory);
+  // Défilement : nouvelle fenêtre demandée au worker (au plus une fois par image)
+  let tableFrame = 0;
+  tableScroll.addEventListener('scroll', ()=>{
+    if(tableFrame) return;
+    tableFrame = requestAnimationFrame(()=>{
+      tableFrame = 0;
+      const first = Math.max(0, Math.min(Math.floor(tableScroll.scrollTop / ROW_H) - 4, table.len - TABLE_POOL));
+      if(first === table.want) return;
+      table.want = first;
+      worker.postMessage({type: 'rows', first});
+    });
+  }, {passive:true});
+
+  reloadBtn.addEventListener('click', ()=>worker.postMessage({type: 'load', full: false}));
+  resSel.addEventListener('change', ()=>{
+    hoverIdxBac = null;
+    hoverIdxCmp = null;
+    worker.postMessage({type: 'resolution', resolution: resSel.value});
+  });
   pauseBtn.addEventListener('click', ()=>{
     paused = !paused;
     pauseBtn.textContent = paused ? 'Reprendre' : 'Pause';
@@ -867,38 +1398,44 @@ static const char INDEX_HTML[] = R"HTML(
  });
 
 
-  // Hover vue bac
-  function setHoverBacFromClientX(clientX){
-    if(history.length < 2) return;
-    const rect = canvasBac.getBoundingClientRect();
+  // Survol : au plus un rendu par image, quelle que soit la fréquence des événements pointeur
+  let hoverFrame = 0;
+  function scheduleHoverRedraw(fn){
+    if(hoverFrame) return;
+    hoverFrame = requestAnimationFrame(()=>{ hoverFrame = 0; fn(); });
+  }
+  function hoverIndex(clientX, canvas){
+    const rect = canvas.getBoundingClientRect();
     const x = clientX - rect.left;
-    const n = history.length;
+    const n = frame.m;
     const idx = Math.round((n-1) * (x / Math.max(1, rect.width)));
-    hoverIdxBac = Math.max(0, Math.min(n-1, idx));
-    redrawBac();
+    return Math.max(0, Math.min(n-1, idx));
+  }
+
+  // Hover vue bac
+  function setHoverBacFromClientX(clientX){
+    if(!frame || frame.m < 2) return;
+    hoverIdxBac = hoverIndex(clientX, canvasBac);
+    scheduleHoverRedraw(redrawBac);
   }
   canvasBac.addEventListener('mousemove', (e)=> setHoverBacFromClientX(e.clientX));
-  canvasBac.addEventListener('mouseleave', ()=>{ hoverIdxBac = null; redrawBac(); });
+  canvasBac.addEventListener('mouseleave', ()=>{ hoverIdxBac = null; scheduleHoverRedraw(redrawBac); });
   canvasBac.addEventListener('touchstart', (e)=>{ if(e.touches?.length) setHoverBacFromClientX(e.touches[0].clientX); }, {passive:true});
   canvasBac.addEventListener('touchmove', (e)=>{ if(e.touches?.length) setHoverBacFromClientX(e.touches[0].clientX); }, {passive:true});
-  canvasBac.addEventListener('touchend', ()=>{ hoverIdxBac = null; redrawBac(); }, {passive:true});
+  canvasBac.addEventListener('touchend', ()=>{ hoverIdxBac = null; scheduleHoverRedraw(redrawBac); }, {passive:true});
 
   // Hover comparaison (sync)
   function setHoverCmpFromClientX(clientX, canvas){
-    if(history.length < 2) return;
-    const rect = canvas.getBoundingClientRect();
-    const x = clientX - rect.left;
-    const n = history.length;
-    const idx = Math.round((n-1) * (x / Math.max(1, rect.width)));
-    hoverIdxCmp = Math.max(0, Math.min(n-1, idx));
-    redrawCompare();
+    if(!frame || frame.m < 2) return;
+    hoverIdxCmp = hoverIndex(clientX, canvas);
+    scheduleHoverRedraw(redrawCompare);
   }
   function bindCmpHover(canvas){
     canvas.addEventListener('mousemove', (e)=> setHoverCmpFromClientX(e.clientX, canvas));
-    canvas.addEventListener('mouseleave', ()=>{ hoverIdxCmp = null; redrawCompare(); });
+    canvas.addEventListener('mouseleave', ()=>{ hoverIdxCmp = null; scheduleHoverRedraw(redrawCompare); });
     canvas.addEventListener('touchstart', (e)=>{ if(e.touches?.length) setHoverCmpFromClientX(e.touches[0].clientX, canvas); }, {passive:true});
     canvas.addEventListener('touchmove', (e)=>{ if(e.touches?.length) setHoverCmpFromClientX(e.touches[0].clientX, canvas); }, {passive:true});
-    canvas.addEventListener('touchend', ()=>{ hoverIdxCmp = null; redrawCompare(); }, {passive:true});
+    canvas.addEventListener('touchend', ()=>{ hoverIdxCmp = null; scheduleHoverRedraw(redrawCompare); }, {passive:true});
   }
   bindCmpHover(canvasTemp);
   bindCmpHover(canvasHum);
@@ -924,16 +1461,16 @@ static const char INDEX_HTML[] = R"HTML(
     es.addEventListener('sample', (ev) => {
       if(paused) return;
       lastMsgMs = Date.now();
-
-      const d = JSON.parse(ev.data);
       lastSeen.textContent = nowLocal();
 
-      history.push(d);
-      if(history.length > 300) history.shift();
+      // Décodage, seuils et store dans le worker : retour en messages cards puis frame
+      worker.postMessage({type: 'sample', json: ev.data, id: Number(ev.lastEventId) || 0});
+    });
 
-      updateCards(d);
-      refreshTable();
-      redrawAll();
+    // Reconnexion après un trou trop grand pour être rejoué : rattrapage incrémental
+    es.addEventListener('resync', () => {
+      lastMsgMs = Date.now();
+      if(!paused) worker.postMessage({type: 'load', full: false, resync: true});
     });
 
     setInterval(()=>{
@@ -944,6 +1481,7 @@ static const char INDEX_HTML[] = R"HTML(
   }
 
   function init(){
+    worker.postMessage({type: 'init', origin: location.origin, px: plotWidth(), rowCount: TABLE_POOL});
     setSelected(1);
     setViewMode('bac');
     startSSE();
@@ -962,15 +1500,18 @@ static const char INDEX_HTML[] = R"HTML(
         console.log('[TIME] Synchro OK:', d);
         // Charger l'historique APRÈS la synchro
         console.log('[INIT] Chargement historique après synchro...');
-        setTimeout(loadHistory, 300);
+        setTimeout(()=>worker.postMessage({type: 'start'}), 300);
       })
       .catch(e => {
         console.log('[TIME] Synchro échouée:', e);
         // Charger quand même si la synchro échoue
-        loadHistory();
+        worker.postMessage({type: 'start'});
       });
     
-    window.addEventListener('resize', ()=>redrawAll());
+    window.addEventListener('resize', ()=>{
+      worker.postMessage({type: 'px', px: plotWidth()});
+      redrawAll();
+    });
   }
   init();
 </script>
@@ -0,0 +1,264 @@
+#include "archive_store.h"
+#include "csv_log.h"
+#include "storage.h"
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+
+static const char ARCHIVE_OPEN_TMP[] = "/archive.tmp";
+
+// ===== Bloc ouvert (RAM, reconstruit depuis le journal /archive.open au premier usage) =====
+// Seul l'écrivain (storagePersist) touche à l'encodeur ; les lecteurs relisent les fichiers.
+static uint8_t openBlock[TS_BLOCK_SIZE];
+static TsBlockEncoder encoder;
+static bool openLoaded = false;
+// Bloc plein scellé mais pas encore dans l'archive (écriture refusée, flash pleine...) : gardé en
+// RAM, le journal garde ses échantillons et les suivants ; nouvel essai à chaque ajout et au boot
+static bool sealPending = false;
+
+static bool readLastSealed(uint8_t *out) {
+  if (!SPIFFS.exists(ARCHIVE_FILE)) return false;
+  File f = SPIFFS.open(ARCHIVE_FILE, FILE_READ);
+  if (!f) return false;
+  size_t size = f.size();
+  bool ok = false;
+  if (size >= TS_BLOCK_SIZE) {
+    f.seek(size - TS_BLOCK_SIZE);
+    ok = f.read(out, TS_BLOCK_SIZE) == TS_BLOCK_SIZE;
+  }
+  f.close();
+  return ok;
+}
+
+// ---------- Journal du bloc ouvert ----------
+// Une ligne CSV avec CRC (csv_record.h) par échantillon, en ajout seul : une coupure ne peut
+// déchirer que la dernière ligne, jamais les échantillons déjà journalisés.
+// Retourne false si une ligne invalide ou un fragment final a été rencontré.
+static bool journalForEach(const std::function<void(const Sample3 &)> &cb) {
+  if (!SPIFFS.exists(ARCHIVE_OPEN_FILE)) return true;
+  File f = SPIFFS.open(ARCHIVE_OPEN_FILE, FILE_READ);
+  if (!f) return false;
+  bool clean = true;
+  char line[CSV_RECORD_MAX];
+  size_t len = 0;
+  bool overflow = false;
+  uint8_t chunk[128];
+  size_t got;
+  Sample3 s;
+  while ((got = f.read(chunk, sizeof(chunk))) > 0) {
+    for (size_t i = 0; i < got; i++) {
+      char c = (char)chunk[i];
+      if (c != '\n') {
+        if (len < sizeof(line)) line[len++] = c;
+        else overflow = true;
+        continue;
+      }
+      if (!overflow && csvParseRecord(line, len, s) == CSV_RECORD_OK) cb(s);
+      else clean = false;
+      len = 0;
+      overflow = false;
+    }
+  }
+  f.close();
+  return clean && len == 0;
+}
+
+static bool journalAppend(const Sample3 &s) {
+  char line[CSV_RECORD_MAX];
+  size_t len = csvFormatRecord(s, line, sizeof(line));
+  File f = SPIFFS.open(ARCHIVE_OPEN_FILE, FILE_APPEND);
+  bool ok = f && len && f.write((const uint8_t *)line, len) == len;
+  if (f) f.close();
+  if (!ok) Serial.println("[ARCHIVE] Erreur journal");
+  return ok;
+}
+
+// Réécrit le journal depuis le bloc ouvert (import initial, fragment déchiré) : fichier
+// temporaire puis rename, l'ancien journal reste entier jusqu'au remplacement
+static void journalRewrite() {
+  encoder.commit();
+  File f = SPIFFS.open(ARCHIVE_OPEN_TMP, FILE_WRITE);
+  bool ok = (bool)f;
+  TsBlockDecoder dec;
+  Sample3 s;
+  if (ok && dec.begin(openBlock)) {
+    char line[CSV_RECORD_MAX];
+    while (ok && dec.next(s)) {
+      size_t len = csvFormatRecord(s, line, sizeof(line));
+      ok = len && f.write((const uint8_t *)line, len) == len;
+    }
+  }
+  if (f) f.close();
+  if (ok) {
+    SPIFFS.remove(ARCHIVE_OPEN_FILE);
+    ok = SPIFFS.rename(ARCHIVE_OPEN_TMP, ARCHIVE_OPEN_FILE);
+  }
+  if (!ok) Serial.println("[ARCHIVE] Erreur reecriture journal");
+}
+
+// Réécrit le journal sans ses n premiers échantillons (bloc archivé) ni ses lignes invalides
+static bool journalDrop(size_t n) {
+  File f = SPIFFS.open(ARCHIVE_OPEN_TMP, FILE_WRITE);
+  bool ok = (bool)f;
+  size_t i = 0;
+  char line[CSV_RECORD_MAX];
+  journalForEach([&](const Sample3 &s) {
+    if (!ok || i++ < n) return;
+    size_t len = csvFormatRecord(s, line, sizeof(line));
+    ok = len && f.write((const uint8_t *)line, len) == len;
+  });
+  if (f) f.close();
+  if (ok) {
+    SPIFFS.remove(ARCHIVE_OPEN_FILE);
+    ok = SPIFFS.rename(ARCHIVE_OPEN_TMP, ARCHIVE_OPEN_FILE);
+  }
+  if (!ok) Serial.println("[ARCHIVE] Erreur reecriture journal");
+  return ok;
+}
+
+// ---------- Scellement ----------
+// Ajoute le bloc scellé à l'archive ; un bloc écrit en partie est retiré (archive alignée)
+static bool writeSealed() {
+  File f = SPIFFS.open(ARCHIVE_FILE, FILE_APPEND);
+  if (!f) return false;
+  size_t before = f.size();
+  size_t written = f.write(openBlock, TS_BLOCK_SIZE);
+  f.close();
+  if (written == TS_BLOCK_SIZE) return true;
+  if (written) storageTruncate(ARCHIVE_FILE, before);
+  return false;
+}
+
+// Bloc en attente archivé : le journal ne garde que les échantillons suivants, rejoués dans un
+// nouveau bloc (de nouveau plein et en attente si l'échec a duré plus d'un bloc)
+static void restartAfterSeal() {
+  size_t n = encoder.count();
+  size_t skip = journalDrop(n) ? 0 : n;
+  sealPending = false;
+  encoder.begin(openBlock);
+  bool full = false;
+  journalForEach([&](const Sample3 &s) {
+    if (skip) {
+      skip--;
+      return;
+    }
+    if (!full && !encoder.append(s)) full = true;
+  });
+  if (full) {
+    encoder.seal();
+    sealPending = true;
+  }
+}
+
+static void flushSealed() {
+  while (sealPending && writeSealed()) restartAfterSeal();
+}
+
+// Ancien format (bloc binaire réécrit à chaque échantillon) : repris, puis converti en journal
+static bool loadLegacyBlock(uint32_t &first) {
+  if (!SPIFFS.exists(ARCHIVE_OPEN_FILE)) return false;
+  File f = SPIFFS.open(ARCHIVE_OPEN_FILE, FILE_READ);
+  if (!f) return false;
+  size_t got = f.read(openBlock, TS_BLOCK_SIZE);
+  f.close();
+  TsBlockDecoder dec;
+  if (got < TS_BLOCK_HEADER || !dec.begin(openBlock) || !encoder.resume(openBlock)) return false;
+  first = dec.firstTime();
+  return true;
+}
+
+static void loadOpenBlock() {
+  if (openLoaded) return;
+  openLoaded = true;
+
+  uint32_t first = 0;
+  bool clean = false;
+  if (!loadLegacyBlock(first)) {
+    memset(openBlock, 0, sizeof(openBlock));
+    encoder.begin(openBlock);
+    bool full = false;
+    clean = journalForEach([&](const Sample3 &s) {
+      if (encoder.count() == 0) first = (uint32_t)s.t;
+      if (!full && !encoder.append(s)) full = true;
+    });
+    // Journal plus long qu'un bloc : scellement refusé avant le redémarrage
+    if (full) {
+      encoder.seal();
+      sealPending = true;
+    }
+  }
+
+  // Coupure entre le scellement et la remise à zéro du journal : bloc déjà archivé
+  uint8_t last[TS_BLOCK_SIZE];
+  TsBlockDecoder sealed;
+  if (encoder.count() > 0 && readLastSealed(last) && sealed.begin(last) &&
+      sealed.firstTime() == first && sealed.count() >= encoder.count()) {
+    if (sealPending) {
+      restartAfterSeal();
+    } else {
+      encoder.begin(openBlock);
+      SPIFFS.remove(ARCHIVE_OPEN_FILE);
+      return;
+    }
+  }
+  // Fragment final déchiré ou ancien format : les ajouts suivants repartent d'un journal propre
+  // (en attente de scellement, le journal dépasse le bloc : réécrit depuis lui-même)
+  if (!clean) {
+    if (sealPending) journalDrop(0);
+    else journalRewrite();
+  }
+  flushSealed();
+}
+
+// journal = false : import en lot, journal réécrit une fois à la fin
+static void appendSample(const Sample3 &s, bool journal) {
+  loadOpenBlock();
+  flushSealed();
+  if (!sealPending) {
+    if (encoder.append(s)) {
+      if (journal) journalAppend(s);
+      return;
+    }
+
+    // Bloc plein : scellé puis ajouté à l'archive, le journal repart de zéro
+    encoder.seal();
+    if (writeSealed()) {
+      SPIFFS.remove(ARCHIVE_OPEN_FILE);
+      encoder.begin(openBlock);
+      encoder.append(s);
+      if (journal) journalAppend(s);
+      return;
+    }
+    // Écriture refusée : le journal est gardé (import : il n'était pas tenu, il reprend le bloc)
+    Serial.println("[ARCHIVE] Erreur ecriture bloc, nouvel essai au prochain ajout");
+    sealPending = true;
+    if (!journal) journalRewrite();
+  }
+  // Échantillons au-delà du bloc en attente : seulement dans le journal jusqu'à l'archivage
+  journalAppend(s);
+}
+
+// ---------- Public API ----------
+void archiveStoreBegin() {
+  // Bloc scellé incomplet en fin d'archive (coupure pendant l'ajout) : retiré
+  if (SPIFFS.exists(ARCHIVE_FILE)) {
+    File f = SPIFFS.open(ARCHIVE_FILE, FILE_READ);
+    size_t size = f ? f.size() : 0;
+    if (f) f.close();
+    if (size % TS_BLOCK_SIZE) storageTruncate(ARCHIVE_FILE, size - size % TS_BLOCK_SIZE);
+    return;
+  }
+  if (SPIFFS.exists(ARCHIVE_OPEN_FILE)) return;
+
+  // Première mise en service : reprendre l'historique CSV existant
+  loadOpenBlock();
+  size_t n = csvLogForEach([](const Sample3 &s) { appendSample(s, false); });
+  journalRewrite();
+  Serial.print("[ARCHIVE] Import CSV: ");
+  Serial.print((unsigned long)n);
+  Serial.println(" lignes");
+}
+
+void archiveStorePush(const Sample3 &s) {
+  appendSample(s, true);
+}
@@ -0,0 +1,129 @@
+#include "clock_store.h"
+#include "csv_log.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <sys/time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+static const uint32_t CLOCK_RTC_MAGIC = 0x45504F32;  // "EPO2" (segments interpolés)
+static const char CLOCK_NVS_NAMESPACE[] = "clock";
+static const char CLOCK_NVS_KEY[] = "epochs";
+static const char CLOCK_FILE_TMP[] = "/epochs.tmp";
+
+// ===== Table courante (RTC) =====
+RTC_DATA_ATTR static uint32_t rtcMagic = 0;
+RTC_DATA_ATTR static EpochTable rtcEpochs;
+static SemaphoreHandle_t epochLock = nullptr;  // /api/settime contre lecteurs (tâches web)
+
+static void epochLockTake() {
+  if (epochLock) xSemaphoreTake(epochLock, portMAX_DELAY);
+}
+
+static void epochLockGive() {
+  if (epochLock) xSemaphoreGive(epochLock);
+}
+
+// ---------- NVS ----------
+static bool epochLoad(EpochTable &tab) {
+  Preferences prefs;
+  if (!prefs.begin(CLOCK_NVS_NAMESPACE, true)) return false;
+  bool ok = prefs.getBytes(CLOCK_NVS_KEY, &tab, sizeof(tab)) == sizeof(tab) && tab.count <= EPOCH_MAX;
+  prefs.end();
+  return ok;
+}
+
+static void epochSave(const EpochTable &tab) {
+  Preferences prefs;
+  if (!prefs.begin(CLOCK_NVS_NAMESPACE, false)) {
+    Serial.println("[CLOCK] Erreur NVS");
+    return;
+  }
+  prefs.putBytes(CLOCK_NVS_KEY, &tab, sizeof(tab));
+  prefs.end();
+}
+
+// ---------- Copie SPIFFS (outils PC) ----------
+// Fichier temporaire puis rename : une coupure laisse l'ancienne copie ou la nouvelle, entière
+static void epochFileSave(const EpochTable &tab) {
+  uint8_t buf[EPOCH_RECORD_MAX];
+  size_t len = epochEncode(tab, buf);
+  File f = SPIFFS.open(CLOCK_FILE_TMP, FILE_WRITE);
+  bool ok = f && f.write(buf, len) == len;
+  if (f) f.close();
+  if (ok) {
+    SPIFFS.remove(EPOCH_FILE);
+    ok = SPIFFS.rename(CLOCK_FILE_TMP, EPOCH_FILE);
+  }
+  if (!ok) Serial.println("[CLOCK] Erreur copie SPIFFS");
+}
+
+static void clockSet(uint32_t raw) {
+  struct timeval tv;
+  tv.tv_sec = raw;
+  tv.tv_usec = 0;
+  settimeofday(&tv, nullptr);
+}
+
+// ---------- Public API ----------
+void clockBegin() {
+  if (!epochLock) epochLock = xSemaphoreCreateMutex();
+
+  uint32_t lastRaw = 0;
+  if (rtcMagic != CLOCK_RTC_MAGIC) {
+    // Mise sous tension : table relue en NVS, dernier temps enregistré relu dans le CSV
+    if (!epochLoad(rtcEpochs)) epochInit(rtcEpochs);
+    if (rtcEpochs.count > 0 && !SPIFFS.exists(EPOCH_FILE)) epochFileSave(rtcEpochs);
+    rtcMagic = CLOCK_RTC_MAGIC;
+    lastRaw = (uint32_t)csvLogLastTime();
+  }
+  if (rtcEpochs.count > 0 && rtcEpochs.seg[rtcEpochs.count - 1].rawFrom > lastRaw) {
+    lastRaw = rtcEpochs.seg[rtcEpochs.count - 1].rawFrom;
+  }
+
+  // Horloge repartie de zéro : elle reprend après le dernier temps connu, sinon les temps
+  // bruts de ce démarrage chevaucheraient ceux d'avant et ne désigneraient plus un seul segment
+  uint32_t now = (uint32_t)time(nullptr);
+  if (lastRaw == 0 || now > lastRaw) return;
+  clockSet(epochBoot(rtcEpochs, lastRaw));
+  epochSave(rtcEpochs);
+  epochFileSave(rtcEpochs);
+  Serial.print("[CLOCK] Horloge reprise apres ");
+  Serial.println((unsigned long)lastRaw);
+}
+
+bool clockSync(time_t realNow) {
+  epochLockTake();
+  uint32_t rawNow = (uint32_t)time(nullptr);
+  uint32_t version = rtcEpochs.version;
+  uint32_t raw = epochSync(rtcEpochs, rawNow, (uint32_t)realNow);
+  bool changed = rtcEpochs.version != version;
+  if (raw != rawNow) clockSet(raw);
+  EpochTable copy = rtcEpochs;
+  epochLockGive();
+
+  if (changed) {
+    epochSave(copy);
+    epochFileSave(copy);
+  }
+  return changed;
+}
+
+void clockEpochs(EpochTable &out) {
+  epochLockTake();
+  out = rtcEpochs;
+  epochLockGive();
+}
+
+int32_t clockOffset(time_t raw) {
+  epochLockTake();
+  int32_t offset = epochOffset(rtcEpochs, (uint32_t)raw);
+  epochLockGive();
+  return offset;
+}
+
+uint32_t clockReal(time_t raw) {
+  return (uint32_t)raw + (uint32_t)clockOffset(raw);
+}
@@ -0,0 +1,83 @@
+#include "csv_export.h"
+#include "fast_format.h"
+#include "date_format.h"
+
+#include <math.h>
+#include <string.h>
+
+static const size_t CSV_EXPORT_ROW_MAX = 128;  // "YYYY-MM-DD HH:MM:SS" + 7 valeurs + '\n'
+
+// Valeur à 2 décimales ("nan" si absente ou hors plage, comme l'ancien export)
+static char *putValue(char *p, float v) {
+  if (fmtFixed2Ok(v)) return fmtFixed2(p, v);
+  memcpy(p, "nan", 3);
+  return p + 3;
+}
+
+static size_t formatRow(CsvExport &e, const Sample3 &s, char *out) {
+  char *p = out;
+  // Anciennes lignes date/heure sans timestamp : date inconnue, champ vide
+  if (s.t != 0) p = fmtDateTime(e.date, p, epochReal(e.epochs, (uint32_t)s.t));
+  for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+    *p++ = ',';
+    p = putValue(p, sample3Get(s, c));
+  }
+  *p++ = '\n';
+  return (size_t)(p - out);
+}
+
+static bool inRange(const CsvExport &e, const Sample3 &s) {
+  if (s.t == 0) return e.from == 0 && e.to == 0xFFFFFFFF;  // Non datées : export complet seulement
+  uint32_t t = epochReal(e.epochs, (uint32_t)s.t);
+  return t >= e.from && t <= e.to;
+}
+
+// Remplit pending avec les lignes suivantes, budget lignes lues au plus
+static void refill(CsvExport &e, size_t &budget) {
+  e.pendLen = e.pendOff = 0;
+  if (!e.started) {
+    size_t n = sizeof(CSV_EXPORT_HEADER) - 1;
+    memcpy(e.pending, CSV_EXPORT_HEADER, n);
+    e.pendLen = n;
+    e.started = true;
+    return;
+  }
+  Sample3 s;
+  while (!e.done && budget > 0 && sizeof(e.pending) - e.pendLen >= CSV_EXPORT_ROW_MAX) {
+    budget--;
+    if (!e.reader.next(s)) {
+      e.done = true;
+      e.reader.close();
+      break;
+    }
+    if (inRange(e, s)) e.pendLen += formatRow(e, s, e.pending + e.pendLen);
+  }
+}
+
+// ---------- Public API ----------
+void csvExportBegin(CsvExport &e, const EpochTable &epochs, uint32_t from, uint32_t to) {
+  e.epochs = epochs;
+  e.from = from;
+  e.to = to;
+  if (!e.reader.open()) e.done = true;  // Journal absent : en-tête seul
+}
+
+size_t csvExportFill(CsvExport &e, uint8_t *buf, size_t maxLen) {
+  size_t n = 0;
+  size_t budget = CSV_SCAN_ROWS_MAX;
+  while (n < maxLen) {
+    if (e.pendOff == e.pendLen) {
+      if (e.started && e.done) break;
+      if (budget == 0) break;  // Morceau partiel : la suite au prochain appel
+      refill(e, budget);
+      if (e.pendLen == 0) continue;  // Fin atteinte ou budget épuisé pendant le remplissage
+    }
+    size_t k = e.pendLen - e.pendOff;
+    if (k > maxLen - n) k = maxLen - n;
+    memcpy(buf + n, e.pending + e.pendOff, k);
+    n += k;
+    e.pendOff += k;
+  }
+  if (n == 0 && !(e.started && e.done)) return CSV_SCAN_AGAIN;  // Filtre : aucune ligne retenue
+  return n;
+}
@@ -0,0 +1,253 @@
+#include "csv_log.h"
+#include "storage.h"
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+static const size_t CSV_RECOVERY_WINDOW = 512;   // Octets relus en fin de fichier au montage
+
+// ===== Lot en RAM (double tampon) =====
+// Fichier logique = logSize octets en flash + back (lot en cours d'écriture) + front (lot courant).
+// Le verrou ne couvre que des copies mémoire : jamais tenu pendant une écriture flash.
+static char batchBuf[2][CSV_BATCH_MAX];
+static uint8_t front = 0;     // back = batchBuf[front ^ 1]
+static size_t frontLen = 0;
+static size_t backLen = 0;    // Non nul seulement pendant commitBatch
+static size_t logSize = 0;    // Octets déjà en flash
+static SemaphoreHandle_t batchLock = nullptr;
+
+static void batchLockTake() {
+  if (batchLock) xSemaphoreTake(batchLock, portMAX_DELAY);
+}
+
+static void batchLockGive() {
+  if (batchLock) xSemaphoreGive(batchLock);
+}
+
+// Écrit les n premiers octets du lot courant ; le reste devient le nouveau lot courant
+static bool commitBatch(size_t n) {
+  batchLockTake();
+  uint8_t b = front;
+  memcpy(batchBuf[b ^ 1], batchBuf[b] + n, frontLen - n);
+  frontLen -= n;
+  backLen = n;
+  front = b ^ 1;
+  batchLockGive();
+
+  File f = SPIFFS.open(CSV_LOG_FILE, FILE_APPEND);
+  size_t written = f ? f.write((const uint8_t *)batchBuf[b], n) : 0;
+  // Écriture courte : taille réelle du fichier, pour que le découpage en pages suive la flash
+  size_t size = (written == n || !f) ? logSize + written : f.size();
+  if (f) f.close();
+
+  batchLockTake();
+  logSize = size;
+  backLen = 0;
+  // Lot perdu (flash pleine...) : le reste, suite d'une ligne coupée, est abandonné aussi.
+  // frontLen = 0 rétablit l'invariant de csvLogAppend même si logSize n'a pas avancé.
+  if (written != n) frontLen = 0;
+  batchLockGive();
+
+  if (written == n) return true;
+  // Une ligne coupée en deux sera ignorée à la lecture
+  Serial.println("[CSV] Erreur ecriture lot");
+  return false;
+}
+
+// Vue cohérente pour un lecteur : taille en flash + copie des lots en RAM (out >= 2 * CSV_BATCH_MAX)
+static void batchSnapshot(size_t &fileLimit, char *out, size_t &len) {
+  batchLockTake();
+  fileLimit = logSize;
+  memcpy(out, batchBuf[front ^ 1], backLen);
+  memcpy(out + backLen, batchBuf[front], frontLen);
+  len = backLen + frontLen;
+  batchLockGive();
+}
+
+// ---------- Récupération ----------
+// Seul le dernier enregistrement peut être déchiré par une coupure : on ne relit que la fin du
+// fichier, on retire le fragment sans '\n' puis les lignes complètes dont le CRC est faux.
+static void recoverTail() {
+  File f = SPIFFS.open(CSV_LOG_FILE, FILE_READ);
+  if (!f) return;
+
+  size_t size = f.size();
+  size_t window = (size < CSV_RECOVERY_WINDOW) ? size : CSV_RECOVERY_WINDOW;
+  size_t base = size - window;
+  char tail[CSV_RECOVERY_WINDOW];
+  f.seek(base);
+  size_t got = f.read((uint8_t *)tail, window);
+  f.close();
+  if (got != window || window == 0) return;
+
+  // 1) Fragment final sans '\n'
+  size_t keep = window;
+  while (keep > 0 && tail[keep - 1] != '\n') keep--;
+  if (keep == 0 && base > 0) keep = window;  // Pas de '\n' dans la fenêtre : rien de sûr à couper
+
+  // 2) Lignes complètes invalides en fin de fichier
+  while (keep > 0) {
+    size_t end = keep - 1;  // position du '\n'
+    size_t start = end;
+    while (start > 0 && tail[start - 1] != '\n') start--;
+    if (start == 0 && base > 0) break;  // Début de ligne hors fenêtre
+
+    Sample3 s;
+    if (csvParseRecord(tail + start, end - start, s) != CSV_RECORD_BAD) break;
+    keep = start;
+  }
+
+  size_t newSize = base + keep;
+  if (newSize == size) return;
+
+  Serial.print("[CSV] Fin de fichier dechiree: ");
+  Serial.print((unsigned long)(size - newSize));
+  Serial.println(" octets retires");
+
+  if (storageTruncate(CSV_LOG_FILE, newSize)) return;
+
+  // VFS sans truncate : clore le fragment par un marqueur invalide pour qu'il soit ignoré à la lecture
+  if (tail[window - 1] != '\n') {
+    File a = SPIFFS.open(CSV_LOG_FILE, FILE_APPEND);
+    if (a) {
+      a.write((const uint8_t *)"!\n", 2);
+      a.close();
+    }
+  }
+}
+
+// ---------- Public API ----------
+void csvLogBegin() {
+  if (!batchLock) batchLock = xSemaphoreCreateMutex();
+  csvLogFlush();  // Rappel (webInit) : la récupération ne doit pas couper une ligne à moitié écrite
+
+  if (SPIFFS.exists(CSV_LOG_FILE)) recoverTail();
+
+  // Créer header CSV s'il n'existe pas (ou si la récupération a tout retiré)
+  File f = SPIFFS.open(CSV_LOG_FILE, FILE_APPEND);
+  size_t size = f ? f.size() : 0;
+  if (f && size == 0) {
+    size = f.println(CSV_HEADER);
+    Serial.println("[CSV] Header cree");
+  }
+  if (f) f.close();
+  logSize = size;
+}
+
+bool csvLogAppend(const Sample3 &s) {
+  char line[CSV_RECORD_MAX];
+  size_t len = csvFormatRecord(s, line, sizeof(line));
+  if (len == 0) return false;
+
+  // frontLen < toPage <= CSV_PAGE_DATA avant l'ajout (commitBatch vide le lot après un échec) :
+  // une ligne tient toujours dans le lot. Vérifié quand même, un débordement écraserait la RAM.
+  batchLockTake();
+  if (frontLen + len > CSV_BATCH_MAX) {
+    batchLockGive();
+    Serial.println("[CSV] Lot plein, ligne refusee");
+    return false;
+  }
+  memcpy(batchBuf[front] + frontLen, line, len);
+  frontLen += len;
+  batchLockGive();
+
+  size_t toPage = CSV_PAGE_DATA - logSize % CSV_PAGE_DATA;  // Jusqu'à la fin de la page de données courante
+  if (frontLen < toPage) return true;
+  return commitBatch(toPage);
+}
+
+bool csvLogFlush() {
+  if (frontLen == 0) return true;
+  return commitBatch(frontLen);
+}
+
+time_t csvLogLastTime() {
+  File f = SPIFFS.open(CSV_LOG_FILE, FILE_READ);
+  if (!f) return 0;
+  char tail[2 * CSV_RECORD_MAX];
+  size_t size = f.size();
+  size_t window = (size < sizeof(tail)) ? size : sizeof(tail);
+  f.seek(size - window);
+  size_t got = f.read((uint8_t *)tail, window);
+  f.close();
+
+  // Lignes complètes, de la dernière vers la première
+  size_t end = got;
+  while (end > 0 && tail[end - 1] != '\n') end--;
+  while (end > 0) {
+    size_t start = end - 1;
+    while (start > 0 && tail[start - 1] != '\n') start--;
+    if (start == 0 && window < size) break;  // Début de ligne hors fenêtre
+    Sample3 s;
+    CsvRecordStatus st = csvParseRecord(tail + start, end - 1 - start, s);
+    if ((st == CSV_RECORD_OK || st == CSV_RECORD_LEGACY) && s.t != 0) return s.t;
+    end = start;
+  }
+  return 0;
+}
+
+size_t csvLogForEach(const std::function<void(const Sample3 &)> &cb) {
+  CsvLogReader reader;
+  if (!reader.open()) return 0;
+  size_t count = 0;
+  Sample3 s;
+  while (reader.next(s)) {
+    cb(s);
+    count++;
+  }
+  reader.close();
+  return count;
+}
+
+// ---------- Lecture séquentielle ----------
+bool CsvLogReader::open() {
+  if (!SPIFFS.exists(CSV_LOG_FILE)) return false;
+  batchSnapshot(fileLimit, pending, pendingLen);
+  f = SPIFFS.open(CSV_LOG_FILE, FILE_READ);
+  fileRead = pendingPos = 0;
+  chunkLen = chunkPos = lineLen = 0;
+  overflow = false;
+  return (bool)f;
+}
+
+bool CsvLogReader::next(Sample3 &s) {
+  if (!f) return false;
+  for (;;) {
+    if (chunkPos == chunkLen) {
+      // Fichier jusqu'à fileLimit, puis lots copiés à l'ouverture
+      size_t want = fileLimit - fileRead;
+      if (want > sizeof(chunk)) want = sizeof(chunk);
+      chunkLen = want ? f.read(chunk, want) : 0;
+      fileRead = chunkLen ? fileRead + chunkLen : fileLimit;  // Fichier raccourci : passer aux lots
+      if (chunkLen == 0 && pendingPos < pendingLen) {
+        chunkLen = pendingLen - pendingPos;
+        if (chunkLen > sizeof(chunk)) chunkLen = sizeof(chunk);
+        memcpy(chunk, pending + pendingPos, chunkLen);
+        pendingPos += chunkLen;
+      }
+      chunkPos = 0;
+      // Un fragment final sans '\n' n'est jamais rendu (écriture interrompue)
+      if (chunkLen == 0) return false;
+    }
+    char c = (char)chunk[chunkPos++];
+    if (c != '\n') {
+      if (lineLen < sizeof(line)) line[lineLen++] = c;
+      else overflow = true;
+      continue;
+    }
+    bool ok = false;
+    if (!overflow && lineLen > 0) {
+      CsvRecordStatus st = csvParseRecord(line, lineLen, s);
+      ok = (st == CSV_RECORD_OK || st == CSV_RECORD_LEGACY);
+    }
+    lineLen = 0;
+    overflow = false;
+    if (ok) return true;
+  }
+}
+
+void CsvLogReader::close() {
+  if (f) f.close();
+}
@@ -0,0 +1,183 @@
+#include "csv_query.h"
+#include "fast_format.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t QUERY_ROW_MAX = 32;  // ",[4294967295,-9999999.99]"
+
+static const char *const QUERY_FIELDS[SAMPLE3_CHANNELS] = {
+  "b1Temp", "b1Hum", "b1O2", "b2Temp", "b2Hum", "b3Temp", "b3Hum"
+};
+static const char *const QUERY_AGGS[] = {"avg", "min", "max", "count"};
+
+// ---------- Helpers ----------
+static void stageStr(CsvQuery &q, const char *s) {
+  size_t n = strlen(s);
+  memcpy(q.pending + q.pendLen, s, n);
+  q.pendLen += n;
+}
+
+static void stageUint(CsvQuery &q, uint32_t v) {
+  q.pendLen = fmtUint(q.pending + q.pendLen, v) - q.pending;
+}
+
+static bool accepted(const CsvQuery &q, float v) {
+  return isfinite(v) && v > q.gt && v < q.lt;
+}
+
+// Ferme le créneau ouvert : [start,valeur]
+static void emitBucket(CsvQuery &q) {
+  stageStr(q, q.rows ? ",[" : "[");
+  stageUint(q, q.start);
+  stageStr(q, ",");
+  if (q.agg == QUERY_COUNT) {
+    stageUint(q, q.n);
+  } else {
+    float v = NAN;
+    if (q.n) v = q.agg == QUERY_MIN ? q.min : q.agg == QUERY_MAX ? q.max : (float)(q.sum / q.n);
+    if (fmtFixed2Ok(v)) q.pendLen = fmtFixed2(q.pending + q.pendLen, v) - q.pending;
+    else stageStr(q, "null");
+  }
+  stageStr(q, "]");
+  q.rows++;
+  q.open = false;
+}
+
+// Premier jour local du créneau de t ; minuit recalculé seulement au changement de créneau
+static bool sameDayBucket(CsvQuery &q, uint32_t t, int32_t &first) {
+  int32_t days = (int32_t)(q.bucket / 86400);
+  int32_t day = dateLocalDay(q.date, (time_t)t);
+  first = day - ((day % days) + days) % days;
+  return q.open && first == q.startDay;
+}
+
+static void addRow(CsvQuery &q, const Sample3 &s) {
+  if (s.t == 0) return;  // Ligne non datée : hors de tout créneau
+  uint32_t t = epochReal(q.epochs, (uint32_t)s.t);
+  if (t < q.from || t > q.to) return;
+
+  bool same;
+  int32_t first = 0;
+  if (q.bucket % 86400 == 0) same = sameDayBucket(q, t, first);
+  else same = q.open && t - t % q.bucket == q.start;
+  if (q.open && !same) emitBucket(q);
+  if (!q.open) {
+    q.open = true;
+    q.startDay = first;
+    q.start = q.bucket % 86400 == 0 ? (uint32_t)dateDayStart(first) : t - t % q.bucket;
+    q.sum = 0;
+    q.n = 0;
+  }
+
+  float v = sample3Get(s, q.ch);
+  if (!accepted(q, v)) return;
+  if (q.n == 0 || v < q.min) q.min = v;
+  if (q.n == 0 || v > q.max) q.max = v;
+  q.sum += v;
+  q.n++;
+}
+
+// Remplit pending, budget lignes lues au plus
+static void refill(CsvQuery &q, size_t &budget) {
+  q.pendLen = q.pendOff = 0;
+  if (!q.started) {
+    stageStr(q, "{\"field\":\"");
+    stageStr(q, QUERY_FIELDS[q.ch]);
+    stageStr(q, "\",\"agg\":\"");
+    stageStr(q, QUERY_AGGS[q.agg]);
+    stageStr(q, "\",\"bucket\":");
+    stageUint(q, q.bucket);
+    stageStr(q, ",\"data\":[");
+    q.started = true;
+    return;
+  }
+
+  Sample3 s;
+  while (!q.done && budget > 0 && sizeof(q.pending) - q.pendLen >= QUERY_ROW_MAX) {
+    budget--;
+    if (!q.reader.next(s)) {
+      q.done = true;
+      q.reader.close();
+      break;
+    }
+    addRow(q, s);
+  }
+  if (q.done && !q.closed && sizeof(q.pending) - q.pendLen >= QUERY_ROW_MAX + 2) {
+    if (q.open) emitBucket(q);
+    stageStr(q, "]}");
+    q.closed = true;
+  }
+}
+
+// ---------- Public API ----------
+bool csvQueryField(const char *name, int &ch) {
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    if (strcmp(name, QUERY_FIELDS[i]) == 0) {
+      ch = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool csvQueryAgg(const char *name, QueryAgg &agg) {
+  for (int i = 0; i <= QUERY_COUNT; i++) {
+    if (strcmp(name, QUERY_AGGS[i]) == 0) {
+      agg = (QueryAgg)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool csvQueryBucket(const char *spec, uint32_t &sec) {
+  char *end;
+  unsigned long v = strtoul(spec, &end, 10);
+  if (end == spec) return false;
+  unsigned long unit = 1;
+  if (*end == 'm') unit = 60;
+  else if (*end == 'h') unit = 3600;
+  else if (*end == 'd') unit = 86400;
+  else if (*end == 's') unit = 1;
+  else if (*end != '\0') return false;
+  if (*end != '\0' && end[1] != '\0') return false;
+  if (v == 0 || v > 0xFFFFFFFFUL / unit || v * unit < QUERY_BUCKET_MIN) return false;
+  sec = (uint32_t)(v * unit);
+  return true;
+}
+
+bool csvQueryValue(const char *spec, float &v) {
+  char *end;
+  float x = strtof(spec, &end);
+  if (end == spec || *end != '\0' || !isfinite(x)) return false;
+  v = x;
+  return true;
+}
+
+void csvQueryBegin(CsvQuery &q, const EpochTable &epochs, uint32_t from, uint32_t to) {
+  q.epochs = epochs;
+  q.from = from;
+  q.to = to;
+  if (!q.reader.open()) q.done = true;  // Journal absent : réponse vide
+}
+
+size_t csvQueryFill(CsvQuery &q, uint8_t *buf, size_t maxLen) {
+  size_t n = 0;
+  size_t budget = CSV_SCAN_ROWS_MAX;
+  while (n < maxLen) {
+    if (q.pendOff == q.pendLen) {
+      if (q.closed) break;
+      if (budget == 0 && !q.done) break;  // Morceau partiel : la suite au prochain appel
+      refill(q, budget);
+      continue;
+    }
+    size_t k = q.pendLen - q.pendOff;
+    if (k > maxLen - n) k = maxLen - n;
+    memcpy(buf + n, q.pending + q.pendOff, k);
+    n += k;
+    q.pendOff += k;
+  }
+  if (n == 0 && !q.closed) return CSV_SCAN_AGAIN;  // Créneau encore ouvert, rien à émettre
+  return n;
+}
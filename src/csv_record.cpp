@@ -0,0 +1,102 @@
+#include "csv_record.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---------- Helpers ----------
+// CRC-16/MODBUS (même polynôme que les trames RS485)
+static uint16_t recordCrc(const char *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint8_t)data[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xA001 : 0);
+  }
+  return crc;
+}
+
+static int hexVal(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Parse "t,v1,...,v7" (sans CRC). Le 1er champ peut être une date (ancien format) -> t = 0.
+static bool parseFields(const char *line, size_t len, Sample3 &s) {
+  char buf[CSV_RECORD_MAX];
+  if (len >= sizeof(buf)) return false;
+  memcpy(buf, line, len);
+  buf[len] = '\0';
+
+  char *fields[8];
+  int n = 0;
+  char *p = buf;
+  while (n < 8) {
+    fields[n++] = p;
+    char *comma = strchr(p, ',');
+    if (!comma) break;
+    *comma = '\0';
+    p = comma + 1;
+  }
+  if (n != 8 || strchr(p, ',')) return false;
+
+  if (strchr(fields[0], ':')) {
+    s.t = 0;  // Format date/heure: YYYY-MM-DD HH:MM:SS (ignoré)
+  } else {
+    char *end;
+    long t = strtol(fields[0], &end, 10);
+    if (end == fields[0] || *end) return false;
+    s.t = (time_t)t;
+  }
+
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    const char *f = fields[i + 1];
+    float v = NAN;
+    if (*f && strcmp(f, "NAN") != 0 && strcmp(f, "nan") != 0) {
+      char *end;
+      v = strtof(f, &end);
+      if (end == f || *end) return false;
+    }
+    sample3Set(s, i, v);
+  }
+  return true;
+}
+
+// ---------- Public API ----------
+size_t csvFormatRecord(const Sample3 &s, char *out, size_t cap) {
+  int n = snprintf(out, cap, "%ld", (long)s.t);
+  for (int i = 0; i < SAMPLE3_CHANNELS && n > 0 && (size_t)n < cap; i++) {
+    float v = sample3Get(s, i);
+    n += isfinite(v) ? snprintf(out + n, cap - n, ",%.2f", v) : snprintf(out + n, cap - n, ",NAN");
+  }
+  if (n <= 0 || (size_t)n + 6 >= cap) return 0;
+  uint16_t crc = recordCrc(out, n);
+  n += snprintf(out + n, cap - n, "*%04X\n", crc);
+  return (size_t)n;
+}
+
+CsvRecordStatus csvParseRecord(const char *line, size_t len, Sample3 &s) {
+  while (len && line[len - 1] == '\r') len--;
+  if (len == 0) return CSV_RECORD_BAD;
+
+  if ((line[0] >= 'a' && line[0] <= 'z') || (line[0] >= 'A' && line[0] <= 'Z')) {
+    return (memchr(line, ',', len) != nullptr) ? CSV_RECORD_HEADER : CSV_RECORD_BAD;
+  }
+
+  if (len > 5 && line[len - 5] == '*') {
+    uint16_t crc = 0;
+    for (int i = 0; i < 4; i++) {
+      int h = hexVal(line[len - 4 + i]);
+      if (h < 0) return CSV_RECORD_BAD;
+      crc = (crc << 4) | h;
+    }
+    if (crc != recordCrc(line, len - 5)) return CSV_RECORD_BAD;
+    return parseFields(line, len - 5, s) ? CSV_RECORD_OK : CSV_RECORD_BAD;
+  }
+
+  return parseFields(line, len, s) ? CSV_RECORD_LEGACY : CSV_RECORD_BAD;
+}
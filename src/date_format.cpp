@@ -0,0 +1,124 @@
+#include "date_format.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// ---------- Calendrier ----------
+// Jours depuis 1970-01-01 <-> date civile (algorithmes de H. Hinnant)
+static int32_t daysFromCivil(int y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civilFromDays(int32_t z, int &y, unsigned &m, unsigned &d) {
+  z += 719468;
+  int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+  unsigned doe = (unsigned)(z - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = (int)yoe + era * 400 + (m <= 2);
+}
+
+static int32_t floorDiv(int64_t a, int64_t b) {
+  return (int32_t)(a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+// Décalage local (TZ courant) à l'instant t, en secondes
+static long localOffset(int64_t t) {
+  time_t tt = (time_t)t;
+  struct tm lt;
+  localtime_r(&tt, &lt);
+  int64_t local = (int64_t)daysFromCivil(lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday) * 86400 +
+                  lt.tm_hour * 3600L + lt.tm_min * 60L + lt.tm_sec;
+  return (long)(local - t);
+}
+
+// Changement d'heure entre a (décalage off) et b (autre décalage) : instant le plus proche de a
+// qui a l'autre décalage
+static int64_t changeNear(int64_t a, int64_t b, long off) {
+  while (a - b > 1 || b - a > 1) {
+    int64_t mid = a + (b - a) / 2;
+    if (localOffset(mid) == off) a = mid;
+    else b = mid;
+  }
+  return b;
+}
+
+static char *put2(char *p, unsigned v) {
+  p[0] = (char)('0' + v / 10);
+  p[1] = (char)('0' + v % 10);
+  return p + 2;
+}
+
+// Reconstruit le cache autour de t : trois localtime_r par jour, une vingtaine les jours de
+// changement d'heure
+static void dateCacheFill(DateCache &c, int64_t t) {
+  long off = localOffset(t);
+  int32_t day = floorDiv(t + off, 86400);
+  c.day = day;
+  c.midnight = (int64_t)day * 86400 - off;
+  c.from = c.midnight;
+  c.to = c.midnight + 86400;
+  if (localOffset(c.from) != off) c.from = changeNear(t, c.from, off) + 1;
+  if (localOffset(c.to - 1) != off) c.to = changeNear(t, c.to - 1, off);
+  // Changement d'heure entre minuit et t : minuit était au décalage d'avant
+  c.dayStart = c.from > c.midnight ? (int64_t)day * 86400 - localOffset(c.from - 1) : c.midnight;
+
+  int y;
+  unsigned m, d;
+  civilFromDays(day, y, m, d);
+  char *p = c.prefix;
+  p = put2(p, (unsigned)(y / 100) % 100);
+  p = put2(p, (unsigned)y % 100);
+  *p++ = '-';
+  p = put2(p, m);
+  *p++ = '-';
+  p = put2(p, d);
+  *p = ' ';
+}
+
+// ---------- Public API ----------
+char *fmtDateTime(DateCache &c, char *p, time_t t) {
+  int64_t x = (int64_t)t;
+  if (x < c.from || x >= c.to) dateCacheFill(c, x);
+  memcpy(p, c.prefix, sizeof(c.prefix));
+  p += sizeof(c.prefix);
+  uint32_t sec = (uint32_t)(x - c.midnight);
+  p = put2(p, sec / 3600);
+  *p++ = ':';
+  p = put2(p, sec / 60 % 60);
+  *p++ = ':';
+  return put2(p, sec % 60);
+}
+
+void dateSetTimezone() {
+  setenv("TZ", DATE_TZ, 1);
+  tzset();
+}
+
+int32_t dateLocalDay(DateCache &c, time_t t) {
+  int64_t x = (int64_t)t;
+  if (x < c.from || x >= c.to) dateCacheFill(c, x);
+  return c.day;
+}
+
+time_t dateLocalMidnight(DateCache &c, time_t t) {
+  int64_t x = (int64_t)t;
+  if (x < c.from || x >= c.to) dateCacheFill(c, x);
+  return (time_t)c.dayStart;
+}
+
+time_t dateDayStart(int32_t day) {
+  // Décalage estimé en lisant local comme un temps UTC, puis relu à l'instant obtenu : exact
+  // même un jour de changement d'heure (sauf changement à minuit pile)
+  int64_t local = (int64_t)day * 86400;
+  int64_t guess = local - localOffset(local);
+  return (time_t)(local - localOffset(guess));
+}
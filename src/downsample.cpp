@@ -0,0 +1,168 @@
+#include "downsample.h"
+
+#include <math.h>
+#include <new>
+
+// Sommet d'un triangle : temps relatif au premier point (s), valeurs par canal
+struct Vertex {
+  float x;
+  float v[SAMPLE3_CHANNELS];
+};
+
+// ---------- Helpers ----------
+// Seau d'un indice du milieu (1 <= k <= count - 2) ; nb seaux répartis sur count - 2 indices
+static uint32_t bucketOf(uint32_t k, uint32_t count, uint32_t nb) {
+  if (k < 1) return 0;
+  if (k > count - 2) return nb - 1;
+  return (uint32_t)((uint64_t)(k - 1) * nb / (count - 2));
+}
+
+static Vertex toVertex(const DownsamplePoint &p, uint32_t t0) {
+  Vertex out;
+  out.x = (float)(int32_t)(p.t - t0);
+  for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) out.v[ch] = p.v[ch];
+  return out;
+}
+
+// Somme des aires (x2) par canal, normalisées ; canaux incomplets ignorés
+static float triangleArea(const Vertex &a, const Vertex &p, const Vertex &c, const float *scale) {
+  float area = 0;
+  for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) {
+    if (scale[ch] == 0 || isnan(a.v[ch]) || isnan(p.v[ch]) || isnan(c.v[ch])) continue;
+    area += fabsf((a.x - c.x) * (p.v[ch] - a.v[ch]) - (a.x - p.x) * (c.v[ch] - a.v[ch])) * scale[ch];
+  }
+  return area;
+}
+
+// ---------- Public API ----------
+size_t lttbSelect(const DownsampleSource &src, uint32_t count, uint16_t points, uint16_t *sel) {
+  if (points < DOWNSAMPLE_MIN_POINTS) points = DOWNSAMPLE_MIN_POINTS;
+  if (count <= points) {
+    size_t n = 0;
+    src([&](uint32_t k, const DownsamplePoint &) {
+      if (k >= count) return false;
+      sel[n++] = (uint16_t)k;
+      return true;
+    });
+    return n;
+  }
+
+  uint32_t nb = points - 2;
+  Vertex *mean = new (std::nothrow) Vertex[nb];
+  if (!mean) return 0;
+
+  // Passe 1 : moyenne de chaque seau, amplitude de chaque canal, premier et dernier points présents
+  float lo[SAMPLE3_CHANNELS], hi[SAMPLE3_CHANNELS];
+  for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) {
+    lo[ch] = INFINITY;
+    hi[ch] = -INFINITY;
+  }
+  DownsamplePoint first{}, last{};
+  uint32_t firstK = 0, lastK = 0;
+  bool any = false;
+
+  uint32_t cur = 0;
+  float sumX = 0, sum[SAMPLE3_CHANNELS] = {};
+  uint32_t nX = 0, n[SAMPLE3_CHANNELS] = {};
+  auto flush = [&]() {
+    mean[cur].x = nX ? sumX / nX : NAN;  // NAN : seau vide
+    for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) {
+      mean[cur].v[ch] = n[ch] ? sum[ch] / n[ch] : NAN;
+      sum[ch] = 0;
+      n[ch] = 0;
+    }
+    sumX = 0;
+    nX = 0;
+  };
+
+  src([&](uint32_t k, const DownsamplePoint &p) {
+    if (k >= count) return false;
+    if (!any) {
+      first = p;
+      firstK = k;
+      any = true;
+    }
+    last = p;
+    lastK = k;
+
+    uint32_t b = bucketOf(k, count, nb);
+    while (cur < b) {
+      flush();
+      cur++;
+    }
+    sumX += (float)(int32_t)(p.t - first.t);
+    nX++;
+    for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) {
+      float v = p.v[ch];
+      if (isnan(v)) continue;
+      sum[ch] += v;
+      n[ch]++;
+      if (v < lo[ch]) lo[ch] = v;
+      if (v > hi[ch]) hi[ch] = v;
+    }
+    return true;
+  });
+  while (cur < nb) {
+    flush();
+    cur++;
+  }
+
+  if (!any) {
+    delete[] mean;
+    return 0;
+  }
+
+  float scale[SAMPLE3_CHANNELS];
+  for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) {
+    scale[ch] = hi[ch] > lo[ch] ? 1.0f / (hi[ch] - lo[ch]) : 0;
+  }
+
+  // Passe 2 : dans chaque seau, le point du plus grand triangle
+  // (point retenu précédent, point candidat, moyenne du prochain seau non vide)
+  size_t out = 0;
+  sel[out++] = (uint16_t)firstK;
+  Vertex a = toVertex(first, first.t);
+  Vertex lastV = toVertex(last, first.t);
+
+  uint32_t b = UINT32_MAX;
+  const Vertex *c = nullptr;
+  float bestArea = -1;
+  uint32_t bestK = 0;
+  Vertex best{};
+  auto close = [&]() {
+    if (bestArea < 0) return;
+    sel[out++] = (uint16_t)bestK;
+    a = best;
+    bestArea = -1;
+  };
+
+  src([&](uint32_t k, const DownsamplePoint &p) {
+    if (k <= firstK) return true;
+    if (k >= lastK) return false;
+    uint32_t bk = bucketOf(k, count, nb);
+    if (bk != b) {
+      close();
+      b = bk;
+      c = &lastV;
+      for (uint32_t i = b + 1; i < nb; i++) {
+        if (!isnan(mean[i].x)) {
+          c = &mean[i];
+          break;
+        }
+      }
+    }
+    Vertex v = toVertex(p, first.t);
+    float area = triangleArea(a, v, *c, scale);
+    if (area > bestArea) {
+      bestArea = area;
+      bestK = k;
+      best = v;
+    }
+    return true;
+  });
+  close();
+  if (lastK != firstK) sel[out++] = (uint16_t)lastK;
+
+  delete[] mean;
+  return out;
+}
@@ -0,0 +1,148 @@
+#include "epoch_table.h"
+
+#include <string.h>
+
+// ---------- Helpers ----------
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int32_t segOffset(const EpochSegment &g, uint32_t raw) {
+  if (raw <= g.rawFrom) return g.offset;
+  if (raw >= g.rawSync) return g.syncOffset;
+  int64_t span = (int64_t)(g.rawSync - g.rawFrom);
+  return g.offset + (int32_t)((int64_t)(g.syncOffset - g.offset) * (int64_t)(raw - g.rawFrom) / span);
+}
+
+// Écart maximal si les segments i et i + 1 n'en font plus qu'un (droite du début de i jusqu'à
+// la synchro de i + 1) : atteint aux points de raccord, les deux fonctions étant affines par morceaux
+static int64_t mergeError(const EpochTable &tab, uint8_t i) {
+  EpochSegment m = tab.seg[i];
+  m.rawSync = tab.seg[i + 1].rawSync;
+  m.syncOffset = tab.seg[i + 1].syncOffset;
+  const EpochSegment &a = tab.seg[i], &b = tab.seg[i + 1];
+  int64_t e1 = (int64_t)a.syncOffset - segOffset(m, a.rawSync);
+  int64_t e2 = (int64_t)a.syncOffset - segOffset(m, b.rawFrom);
+  int64_t e3 = (int64_t)b.offset - segOffset(m, b.rawFrom);
+  if (e1 < 0) e1 = -e1;
+  if (e2 < 0) e2 = -e2;
+  if (e3 < 0) e3 = -e3;
+  int64_t e = e1 > e2 ? e1 : e2;
+  return e > e3 ? e : e3;
+}
+
+// Table pleine : fusionne les deux segments voisins dont la fusion déplace le moins les heures
+// réelles. Le premier segment (avant toute synchro, décalage souvent énorme) n'est jamais fusionné.
+static void mergeCheapest(EpochTable &tab) {
+  uint8_t best = 1;
+  int64_t bestErr = mergeError(tab, 1);
+  for (uint8_t i = 2; i + 1 < tab.count; i++) {
+    int64_t e = mergeError(tab, i);
+    if (e < bestErr) {
+      bestErr = e;
+      best = i;
+    }
+  }
+  tab.seg[best].rawSync = tab.seg[best + 1].rawSync;
+  tab.seg[best].syncOffset = tab.seg[best + 1].syncOffset;
+  memmove(tab.seg + best + 1, tab.seg + best + 2, (tab.count - best - 2) * sizeof(EpochSegment));
+  tab.count--;
+}
+
+// Ajoute un segment ouvert en fin de table
+static void pushSegment(EpochTable &tab, uint32_t rawFrom, int32_t offset) {
+  if (tab.count > 0 && tab.seg[tab.count - 1].rawFrom == rawFrom) {
+    tab.count--;  // Segment vide : remplacé
+  } else if (tab.count == EPOCH_MAX) {
+    mergeCheapest(tab);
+  }
+  EpochSegment &g = tab.seg[tab.count++];
+  g.rawFrom = g.rawSync = rawFrom;
+  g.offset = g.syncOffset = offset;
+}
+
+// ---------- Public API ----------
+void epochInit(EpochTable &tab) {
+  memset(&tab, 0, sizeof(tab));
+}
+
+int32_t epochOffset(const EpochTable &tab, uint32_t raw) {
+  if (tab.count == 0) return 0;
+  // Dernier segment avec rawFrom <= raw
+  uint8_t lo = 0, hi = tab.count;
+  while (hi - lo > 1) {
+    uint8_t mid = (uint8_t)((lo + hi) / 2);
+    if (tab.seg[mid].rawFrom <= raw) lo = mid;
+    else hi = mid;
+  }
+  return segOffset(tab.seg[lo], raw);
+}
+
+uint32_t epochSync(EpochTable &tab, uint32_t rawNow, uint32_t realNow) {
+  int32_t d = (int32_t)(realNow - rawNow);
+  int32_t current = epochOffset(tab, rawNow);
+  if (tab.count > 0 && d - current < EPOCH_MIN_STEP && current - d < EPOCH_MIN_STEP) return rawNow;
+
+  if (tab.count == 0) pushSegment(tab, 0, d);  // Avant la première synchro : décalage constant
+  EpochSegment &last = tab.seg[tab.count - 1];
+  last.rawSync = rawNow;
+  last.syncOffset = d;
+  tab.version++;
+
+  if (d > 0) {
+    pushSegment(tab, realNow, 0);  // Horloge avancée : brut = réel à partir d'ici
+    return realNow;
+  }
+  pushSegment(tab, rawNow, d);
+  return rawNow;
+}
+
+uint32_t epochBoot(EpochTable &tab, uint32_t lastRaw) {
+  int32_t offset = epochOffset(tab, lastRaw);
+  pushSegment(tab, lastRaw + 1, offset);
+  tab.version++;
+  return lastRaw + 1;
+}
+
+size_t epochEncode(const EpochTable &tab, uint8_t *out) {
+  put32(out, tab.version);
+  out[4] = tab.count;
+  uint8_t *p = out + 5;
+  for (uint8_t i = 0; i < tab.count; i++) {
+    const EpochSegment &g = tab.seg[i];
+    put32(p, g.rawFrom);
+    put32(p + 4, (uint32_t)g.offset);
+    put32(p + 8, g.rawSync);
+    put32(p + 12, (uint32_t)g.syncOffset);
+    p += 16;
+  }
+  return (size_t)(p - out);
+}
+
+bool epochDecode(const uint8_t *in, size_t len, EpochTable &tab) {
+  epochInit(tab);
+  if (len < 5 || in[4] > EPOCH_MAX || len != 5 + (size_t)in[4] * 16) return false;
+  const uint8_t *p = in + 5;
+  for (uint8_t i = 0; i < in[4]; i++) {
+    EpochSegment &g = tab.seg[i];
+    g.rawFrom = get32(p);
+    g.offset = (int32_t)get32(p + 4);
+    g.rawSync = get32(p + 8);
+    g.syncOffset = (int32_t)get32(p + 12);
+    p += 16;
+    if (g.rawSync < g.rawFrom || (i > 0 && g.rawFrom <= tab.seg[i - 1].rawFrom)) {
+      epochInit(tab);
+      return false;
+    }
+  }
+  tab.version = get32(in);
+  tab.count = in[4];
+  return true;
+}
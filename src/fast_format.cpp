@@ -0,0 +1,40 @@
+#include "fast_format.h"
+
+#include <math.h>
+
+bool fmtFixed2Ok(float v) {
+  return isfinite(v) && fabsf(v) < 1e7f;
+}
+
+char *fmtUint(char *p, uint32_t v) {
+  char tmp[10];
+  int n = 0;
+  do {
+    tmp[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n) *p++ = tmp[--n];
+  return p;
+}
+
+char *fmtInt(char *p, int32_t v) {
+  if (v < 0) {
+    *p++ = '-';
+    return fmtUint(p, 0u - (uint32_t)v);
+  }
+  return fmtUint(p, (uint32_t)v);
+}
+
+char *fmtFixed2(char *p, float v) {
+  int32_t c = (int32_t)lroundf(v * 100.0f);
+  if (c < 0) {
+    *p++ = '-';
+    c = -c;
+  }
+  p = fmtUint(p, (uint32_t)c / 100);
+  unsigned frac = (unsigned)c % 100;
+  p[0] = '.';
+  p[1] = (char)('0' + frac / 10);
+  p[2] = (char)('0' + frac % 10);
+  return p + 3;
+}
@@ -0,0 +1,257 @@
+#include "history_ring.h"
+
+#include <atomic>
+#include <math.h>
+
+#if defined(ARDUINO)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+static_assert(HISTORY_SIZE > 0 && HISTORY_SIZE <= 65535, "HISTORY_SIZE hors plage");
+
+static const int16_t HIST_NAN = -32768;      // Valeur absente (NAN)
+static const uint16_t HIST_DT_ANCHOR = 0xFFFF;  // Écart hors plage : temps dans la file d'ancres
+
+// ===== Colonnes =====
+// Un seul écrivain (historyPush / historyClear, tâche réseau du pipeline) ; lecteurs concurrents
+// (tâche AsyncTCP : /api/history, /api/latest, rejeu SSE) sans verrou ni attente de l'écrivain :
+//  - l'en-tête (position, temps, ancres) est copié par seqlock : seqBegun avance avant une
+//    écriture, seqDone après ; une copie est cohérente si aucune écriture n'a commencé entre-temps ;
+//  - une écriture ne modifie que la case de la séquence poussée, qui écrase celle de
+//    séquence - HISTORY_SIZE : une case lue est valide si seqBegun ne l'a pas encore atteinte.
+static int16_t histCh[SAMPLE3_CHANNELS][HISTORY_SIZE];
+static uint16_t histDt[HISTORY_SIZE];  // Écart avec l'échantillon précédent (s)
+
+struct RingHeader {
+  size_t head;
+  size_t count;
+  uint32_t tailT;  // Temps du plus ancien échantillon
+  uint32_t headT;  // Temps du plus récent
+  // Temps absolus des échantillons marqués HIST_DT_ANCHOR, dans l'ordre du ring.
+  // L'écart du plus ancien n'est jamais lu (son temps est tailT).
+  size_t anchorCount;
+  uint32_t anchors[HISTORY_ANCHORS];
+  uint32_t anchorBase;  // Rang absolu de anchors[0] (ancres déjà retirées) : repère des curseurs
+};
+
+static RingHeader ring = {};
+static std::atomic<uint32_t> seqBegun(0);  // Séquence de fin de la dernière écriture commencée
+static std::atomic<uint32_t> seqDone(0);   // Séquence du prochain échantillon (écritures terminées)
+
+// Attente d'un écrivain interrompu en pleine écriture (lecteur prioritaire sur le même cœur)
+static const int RING_SPINS = 8;
+#if defined(ARDUINO)
+#define RING_BACKOFF() vTaskDelay(1)
+#else
+#define RING_BACKOFF() std::this_thread::yield()
+#endif
+
+// ---------- Helpers ----------
+static int16_t quantize(float v) {
+  if (!isfinite(v)) return HIST_NAN;
+  float c = roundf(v * 100.0f);
+  if (c > 32767.0f) c = 32767.0f;
+  if (c < -32767.0f) c = -32767.0f;
+  return (int16_t)c;
+}
+
+static float dequantize(int16_t q) {
+  return q == HIST_NAN ? NAN : q / 100.0f;
+}
+
+static void popAnchor() {
+  for (size_t i = 1; i < ring.anchorCount; i++) ring.anchors[i - 1] = ring.anchors[i];
+  ring.anchorCount--;
+  ring.anchorBase++;
+}
+
+// Les cases évincées ne sont pas modifiées : un lecteur sur un en-tête plus ancien les lit encore
+static void evictOldest() {
+  size_t tail = (ring.head + HISTORY_SIZE - ring.count) % HISTORY_SIZE;
+  ring.count--;
+  if (ring.count == 0) return;
+
+  // Le suivant devient le plus ancien : son temps passe dans tailT
+  size_t next = (tail + 1) % HISTORY_SIZE;
+  if (histDt[next] == HIST_DT_ANCHOR) {
+    ring.tailT = ring.anchors[0];
+    popAnchor();
+  } else {
+    ring.tailT += histDt[next];
+  }
+}
+
+static void readSlot(size_t idx, uint32_t t, Sample3 &s) {
+  s.t = (time_t)t;
+  for (int c = 0; c < SAMPLE3_CHANNELS; c++) sample3Set(s, c, dequantize(histCh[c][idx]));
+}
+
+// ---------- Seqlock ----------
+static void beginWrite(uint32_t end) {
+  seqBegun.store(end, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void endWrite(uint32_t end) {
+  seqDone.store(end, std::memory_order_release);
+}
+
+// Copie cohérente de l'en-tête ; retourne la séquence de fin correspondante
+static uint32_t snapshot(RingHeader &h) {
+  for (int tries = 0;; tries++) {
+    uint32_t end = seqDone.load(std::memory_order_acquire);
+    h = ring;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seqBegun.load(std::memory_order_relaxed) == end) return end;
+    if (tries >= RING_SPINS) RING_BACKOFF();
+  }
+}
+
+// Case de la séquence seq lue juste avant : pas encore réécrite par une écriture commencée
+static bool slotStable(uint32_t seq) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return (int32_t)(seq + HISTORY_SIZE - seqBegun.load(std::memory_order_relaxed)) >= 0;
+}
+
+// ---------- API ----------
+void historyPush(const Sample3 &s) {
+  uint32_t seq = seqDone.load(std::memory_order_relaxed);
+  beginWrite(seq + 1);
+
+  uint32_t t = (uint32_t)s.t;
+  if (ring.count == HISTORY_SIZE) evictOldest();
+
+  // Écart négatif ou >= 18 h : ancre (libérée en évinçant les plus anciens si la file est pleine)
+  bool jump = ring.count > 0 && (t < ring.headT || t - ring.headT >= HIST_DT_ANCHOR);
+  if (jump) {
+    while (ring.anchorCount == HISTORY_ANCHORS && ring.count > 0) evictOldest();
+    jump = ring.count > 0;
+  }
+
+  uint16_t dt = 0;
+  if (ring.count == 0) {
+    ring.tailT = t;
+  } else if (jump) {
+    ring.anchors[ring.anchorCount++] = t;
+    dt = HIST_DT_ANCHOR;
+  } else {
+    dt = (uint16_t)(t - ring.headT);
+  }
+
+  histDt[ring.head] = dt;
+  for (int c = 0; c < SAMPLE3_CHANNELS; c++) histCh[c][ring.head] = quantize(sample3Get(s, c));
+  ring.head = (ring.head + 1) % HISTORY_SIZE;
+  ring.count++;
+  ring.headT = t;
+
+  endWrite(seq + 1);
+}
+
+// Les séquences sautent de HISTORY_SIZE : toute case en cours de lecture devient périmée
+void historyClear() {
+  uint32_t seq = seqDone.load(std::memory_order_relaxed) + HISTORY_SIZE;
+  beginWrite(seq);
+  ring.head = 0;
+  ring.count = 0;
+  ring.anchorBase += (uint32_t)ring.anchorCount;
+  ring.anchorCount = 0;
+  endWrite(seq);
+}
+
+size_t historyCount() {
+  RingHeader h;
+  snapshot(h);
+  return h.count;
+}
+
+void historyRange(uint32_t &first, uint32_t &end) {
+  RingHeader h;
+  end = snapshot(h);
+  first = end - (uint32_t)h.count;
+}
+
+bool historyLatest(Sample3 &s) {
+  for (;;) {
+    RingHeader h;
+    uint32_t end = snapshot(h);
+    if (h.count == 0) return false;
+    readSlot((h.head + HISTORY_SIZE - 1) % HISTORY_SIZE, h.headT, s);
+    if (slotStable(end - 1)) return true;
+  }
+}
+
+uint32_t historySeq() {
+  return seqDone.load(std::memory_order_acquire);
+}
+
+void historyForEachFrom(uint32_t fromSeq, const std::function<bool(uint32_t, const Sample3 &)> &cb,
+                        HistoryCursor &cursor) {
+  RingHeader h;
+  Sample3 s;
+  for (;;) {
+    uint32_t end = snapshot(h);
+    uint32_t first = end - (uint32_t)h.count;
+
+    // Reprise au curseur s'il est encore derrière un échantillon présent (pas le plus ancien :
+    // son temps est alors tailT) ; sinon les temps sont reconstruits depuis le plus ancien
+    uint32_t seq = first;
+    size_t idx = (h.head + HISTORY_SIZE - h.count) % HISTORY_SIZE;
+    uint32_t t = h.tailT;
+    size_t anchor = 0;
+    bool fresh = true;
+    if (cursor.valid && (int32_t)(cursor.seq - first) > 0 && (int32_t)(end - cursor.seq) >= 0 &&
+        (int32_t)(fromSeq - cursor.seq) >= 0 && cursor.anchor - h.anchorBase <= h.anchorCount) {
+      seq = cursor.seq;
+      idx = cursor.idx;
+      t = cursor.prevT;
+      anchor = cursor.anchor - h.anchorBase;
+      fresh = false;
+    }
+
+    bool stable = true;
+    for (; seq != end; seq++, fresh = false) {
+      uint32_t prevT = t;
+      size_t prevAnchor = anchor;
+      uint16_t dt = histDt[idx];
+      if (!fresh) {
+        if (dt != HIST_DT_ANCHOR) t += dt;
+        else if (anchor < h.anchorCount) t = h.anchors[anchor++];
+      }
+      bool wanted = (int32_t)(seq - fromSeq) >= 0;
+      if (wanted) readSlot(idx, t, s);
+      if (!slotStable(seq)) {
+        stable = false;
+        break;
+      }
+      // Arrêt possible dans cb : la reprise relira cet échantillon
+      cursor = {true, seq, idx, prevT, h.anchorBase + (uint32_t)prevAnchor};
+      if (fresh) cursor.valid = false;  // Plus ancien : temps dans tailT, pas dérivable de prevT
+      if (wanted && !cb(seq, s)) return;
+      idx = (idx + 1) % HISTORY_SIZE;
+    }
+    if (stable) {
+      cursor = {true, end, idx, t, h.anchorBase + (uint32_t)anchor};
+      return;
+    }
+    // Case réécrite pendant la lecture (échantillon évincé) : reprise après elle, nouvel en-tête
+    cursor.valid = false;
+    if ((int32_t)(seq + 1 - fromSeq) > 0) fromSeq = seq + 1;
+  }
+}
+
+void historyForEachFrom(uint32_t fromSeq, const std::function<bool(uint32_t, const Sample3 &)> &cb) {
+  HistoryCursor cursor;
+  historyForEachFrom(fromSeq, cb, cursor);
+}
+
+void historyForEach(const std::function<void(const Sample3 &)> &cb) {
+  uint32_t first, end;
+  historyRange(first, end);
+  historyForEachFrom(first, [&](uint32_t, const Sample3 &s) {
+    cb(s);
+    return true;
+  });
+}
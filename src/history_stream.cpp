@@ -0,0 +1,368 @@
+#include "history_stream.h"
+#include "history_ring.h"
+#include "rollup_store.h"
+#include "json_writer.h"
+#include "downsample.h"
+
+#include <math.h>
+#include <new>
+#include <string.h>
+
+static const size_t STREAM_PENDING_SIZE = 1536;  // >= 3 créneaux agrégés en lignes JSON
+static const size_t STREAM_ITEM_RESERVE = 48;    // Place garantie avant un fragment de colonne
+
+// Passes : en-tête, puis soit les lignes, soit une passe par colonne, puis fin
+enum : uint8_t {
+  PASS_HEADER = 0,
+  PASS_ROWS,
+  PASS_TIME,
+  PASS_COUNT,
+  PASS_VALUES,                                     // 3 groupes (moy/min/max) x 7 canaux
+  PASS_FOOTER = PASS_VALUES + 3 * SAMPLE3_CHANNELS,
+  PASS_END
+};
+
+enum { GROUP_MEAN = 0, GROUP_MIN = 1, GROUP_MAX = 2 };
+
+struct HistoryStream {
+  HistoryResolution res;
+  HistoryFormat fmt;
+  EpochTable epochs;       // Segments d'horloge (figés à la requête)
+  uint32_t first = 0;      // Points [first, first + count) : séquences du ring ou index d'agrégat
+  uint32_t count = 0;
+  uint16_t *sel = nullptr; // Sous-échantillonnage : indices retenus (relatifs à first), sinon tous
+  uint32_t outCount = 0;   // Points émis
+  uint32_t t0 = 0;
+  uint8_t pass = PASS_HEADER;
+  bool passStarted = false;
+  uint32_t k = 0;          // Prochain point de la passe
+  uint32_t items = 0;      // Lignes émises (placement des virgules)
+  uint32_t prevT = 0;
+  HistoryCursor cursor;    // Reprise du parcours du ring d'un appel à l'autre (brut)
+  size_t pendLen = 0;
+  size_t pendOff = 0;
+  char pending[STREAM_PENDING_SIZE];
+
+  ~HistoryStream() { delete[] sel; }
+};
+
+// Un point : échantillon brut ou créneau agrégé
+struct PointRef {
+  const Sample3 *s;
+  const RollupBucket *b;
+};
+
+// ---------- Helpers ----------
+static bool isRollup(const HistoryStream &st) {
+  return st.res != HISTORY_RAW;
+}
+
+static RollupTier tierOf(const HistoryStream &st) {
+  return st.res == HISTORY_DAY ? ROLLUP_DAY : ROLLUP_HOUR;
+}
+
+static uint32_t pointTime(const HistoryStream &st, const PointRef &p) {
+  return p.s ? epochReal(st.epochs, (uint32_t)p.s->t) : p.b->start;  // Agrégats déjà en heure réelle
+}
+
+static float pointValue(const PointRef &p, int group, int ch) {
+  if (p.s) return sample3Get(*p.s, ch);
+  if (group == GROUP_MIN) return rollupMin(p.b->ch[ch]);
+  if (group == GROUP_MAX) return rollupMax(p.b->ch[ch]);
+  return rollupMean(p.b->ch[ch]);
+}
+
+// Indice source du j-ième point émis
+static uint32_t srcIndex(const HistoryStream &st, uint32_t j) {
+  return st.sel ? st.sel[j] : j;
+}
+
+static int16_t toCenti16(float v) {
+  if (!isfinite(v)) return -32768;
+  float c = roundf(v * 100.0f);
+  if (c > 32767.0f) c = 32767.0f;
+  if (c < -32767.0f) c = -32767.0f;
+  return (int16_t)c;
+}
+
+static size_t space(const HistoryStream &st) {
+  return sizeof(st.pending) - st.pendLen;
+}
+
+static void stage(HistoryStream &st, const void *p, size_t n) {
+  memcpy(st.pending + st.pendLen, p, n);
+  st.pendLen += n;
+}
+
+static void stageStr(HistoryStream &st, const char *s) {
+  stage(st, s, strlen(s));
+}
+
+static void stageLE(HistoryStream &st, uint32_t v, size_t bytes) {
+  for (size_t i = 0; i < bytes; i++) st.pending[st.pendLen++] = (char)((v >> (8 * i)) & 0xFF);
+}
+
+// Parcourt les points sources à partir de from ; cb(k, point) retourne false pour s'arrêter
+template <typename F>
+static void visit(HistoryStream &st, uint32_t from, F cb) {
+  if (!isRollup(st)) {
+    historyForEachFrom(st.first + from, [&](uint32_t seq, const Sample3 &s) {
+      uint32_t k = seq - st.first;
+      if (k >= st.count) return false;
+      return cb(k, PointRef{&s, nullptr});
+    }, st.cursor);
+  } else {
+    rollupStoreForEachFrom(tierOf(st), st.first + from, [&](size_t index, const RollupBucket &b) {
+      uint32_t k = (uint32_t)(index - st.first);
+      if (k >= st.count) return false;
+      return cb(k, PointRef{nullptr, &b});
+    });
+  }
+}
+
+// ---------- Passes ----------
+static bool isPointPass(uint8_t pass) {
+  return pass >= PASS_ROWS && pass < PASS_FOOTER;
+}
+
+static uint8_t nextPass(const HistoryStream &st) {
+  uint8_t p = st.pass;
+  if (p == PASS_HEADER) return st.fmt == HISTORY_FORMAT_ROWS ? PASS_ROWS : PASS_TIME;
+  if (p == PASS_ROWS) return PASS_FOOTER;
+  if (p == PASS_TIME) return isRollup(st) ? PASS_COUNT : PASS_VALUES;
+  if (p == PASS_COUNT) return PASS_VALUES;
+  if (p == PASS_VALUES + SAMPLE3_CHANNELS - 1 && !isRollup(st)) return PASS_FOOTER;
+  return p + 1;
+}
+
+static void beginPass(HistoryStream &st) {
+  bool json = st.fmt != HISTORY_FORMAT_BINARY;
+  char num[FMT_INT_MAX];
+
+  if (st.pass == PASS_HEADER) {
+    if (st.fmt == HISTORY_FORMAT_ROWS) {
+      stageStr(st, "[");
+    } else if (json) {
+      stageStr(st, "{\"t0\":");
+      stage(st, num, fmtUint(num, st.t0) - num);
+      stageStr(st, ",");
+    } else {
+      stageLE(st, HISTORY_BIN_MAGIC, 2);
+      stageLE(st, HISTORY_BIN_VERSION, 1);
+      stageLE(st, isRollup(st) ? HISTORY_BIN_ROLLUP : 0, 1);
+      stageLE(st, st.outCount, 2);
+      stageLE(st, SAMPLE3_CHANNELS, 2);
+      stageLE(st, st.t0, 4);
+    }
+  } else if (!json) {
+    return;
+  } else if (st.pass == PASS_TIME) {
+    stageStr(st, "\"dt\":[");
+  } else if (st.pass == PASS_COUNT) {
+    stageStr(st, "],\"n\":[");
+  } else if (st.pass >= PASS_VALUES && st.pass < PASS_FOOTER) {
+    // Fermeture du tableau précédent ; au 1er canal d'un groupe, fermeture de b3 et du groupe
+    static const char *const GROUP_OPEN[] = {"],", "]},\"min\":{", "]}},\"max\":{"};
+    int v = st.pass - PASS_VALUES;
+    int ch = v % SAMPLE3_CHANNELS;
+    stageStr(st, ch == 0 ? GROUP_OPEN[v / SAMPLE3_CHANNELS] : "]");
+    stage(st, SAMPLE3_JSON_FIELDS[ch].prefix, SAMPLE3_JSON_FIELDS[ch].prefixLen);
+    stageStr(st, "[");
+  } else if (st.pass == PASS_FOOTER) {
+    if (st.fmt == HISTORY_FORMAT_ROWS) stageStr(st, "]");
+    else stageStr(st, isRollup(st) ? "]}}}" : "]}}");
+  }
+}
+
+// Un point de la passe courante ; p == nullptr : point disparu (évincé entre deux appels).
+// false si le tampon est plein (st.k inchangé).
+static bool emitPoint(HistoryStream &st, const PointRef *p) {
+  bool json = st.fmt != HISTORY_FORMAT_BINARY;
+  const char *sep = st.k ? "," : "";
+
+  if (st.pass == PASS_ROWS) {
+    if (p) {
+      size_t s = st.items ? 1 : 0;
+      if (space(st) <= s) return false;
+      char *out = st.pending + st.pendLen;
+      size_t n = p->s ? jsonSample(out + s, space(st) - s, *p->s, epochOffset(st.epochs, (uint32_t)p->s->t))
+                      : jsonRollup(out + s, space(st) - s, *p->b);
+      if (n == 0) return false;
+      if (s) out[0] = ',';
+      st.pendLen += s + n;
+      st.items++;
+    }
+    st.k++;
+    return true;
+  }
+
+  if (space(st) < STREAM_ITEM_RESERVE) return false;
+  char num[FMT_FIXED2_MAX + FMT_INT_MAX];
+
+  if (st.pass == PASS_TIME) {
+    uint32_t t = p ? pointTime(st, *p) : st.prevT;
+    // Temps réels croissants (segments continus, epoch_table.h) ; un recul résiduel donne 0
+    uint32_t dt = (st.k && t > st.prevT) ? t - st.prevT : 0;
+    if (t > st.prevT) st.prevT = t;
+    if (json) {
+      stageStr(st, sep);
+      stage(st, num, fmtUint(num, dt) - num);
+    } else {
+      stageLE(st, dt, 4);
+    }
+  } else if (st.pass == PASS_COUNT) {
+    uint16_t n = p ? p->b->samples : 0;
+    if (json) {
+      stageStr(st, sep);
+      stage(st, num, fmtUint(num, n) - num);
+    } else {
+      stageLE(st, n, 2);
+    }
+  } else {
+    int v = st.pass - PASS_VALUES;
+    float val = p ? pointValue(*p, v / SAMPLE3_CHANNELS, v % SAMPLE3_CHANNELS) : NAN;
+    if (json) {
+      stageStr(st, sep);
+      if (fmtFixed2Ok(val)) stage(st, num, fmtFixed2(num, val) - num);
+      else stageStr(st, "null");
+    } else {
+      stageLE(st, (uint16_t)toCenti16(val), 2);
+    }
+  }
+  st.k++;
+  return true;
+}
+
+// Remplit pending ; retourne quand il est plein ou que la réponse est terminée
+static void refill(HistoryStream &st) {
+  st.pendLen = st.pendOff = 0;
+  while (st.pass != PASS_END && space(st) >= STREAM_ITEM_RESERVE) {
+    if (!st.passStarted) {
+      beginPass(st);
+      st.passStarted = true;
+    }
+
+    if (isPointPass(st.pass)) {
+      bool full = false;
+      if (st.k < st.outCount) {
+        visit(st, srcIndex(st, st.k), [&](uint32_t k, const PointRef &p) {
+          while (!full && st.k < st.outCount && srcIndex(st, st.k) < k) full = !emitPoint(st, nullptr);
+          if (full || st.k >= st.outCount) return false;
+          if (srcIndex(st, st.k) > k) return true;  // Point écarté par le sous-échantillonnage
+          full = !emitPoint(st, &p);
+          return !full;
+        });
+      }
+      // Source épuisée avant la fin : points manquants
+      while (!full && st.k < st.outCount) {
+        if (!emitPoint(st, nullptr)) full = true;
+      }
+      if (full) return;
+    }
+
+    st.pass = nextPass(st);
+    st.passStarted = false;
+    st.k = 0;
+    st.prevT = st.t0;
+  }
+}
+
+// ---------- Public API ----------
+HistoryStream *historyStreamCreate(HistoryResolution res, HistoryFormat fmt, const EpochTable &epochs,
+                                   size_t maxPoints, uint32_t since, uint16_t points) {
+  HistoryStream *st = new (std::nothrow) HistoryStream;
+  if (!st) return nullptr;
+  st->res = res;
+  st->fmt = fmt;
+  st->epochs = epochs;
+
+  if (res == HISTORY_RAW) {
+    uint32_t end;
+    historyRange(st->first, end);
+    st->count = end - st->first;
+  } else {
+    // Sous-échantillonné : tout le niveau ; sinon les maxPoints derniers créneaux
+    size_t begin, end;
+    rollupStoreRange(tierOf(*st), begin, end);
+    size_t first = (!points && end - begin > maxPoints) ? end - maxPoints : begin;
+    st->first = (uint32_t)first;
+    st->count = (uint32_t)(end - first);
+  }
+  if (st->count > 0xFFFF) {  // Compteur binaire sur 16 bits
+    st->first += st->count - 0xFFFF;
+    st->count = 0xFFFF;
+  }
+
+  // Incrémental : reprise après le dernier point déjà connu du client
+  if (since > 0) {
+    uint32_t skip = 0;
+    visit(*st, 0, [&](uint32_t k, const PointRef &p) {
+      if (pointTime(*st, p) <= since) skip = k + 1;
+      return true;
+    });
+    st->first += skip;
+    st->count -= skip;
+  }
+
+  st->outCount = st->count;
+  if (points && st->count > points) {
+    if (points < DOWNSAMPLE_MIN_POINTS) points = DOWNSAMPLE_MIN_POINTS;
+    st->sel = new (std::nothrow) uint16_t[points];
+    if (!st->sel) {
+      delete st;
+      return nullptr;
+    }
+    DownsampleSource src = [&](const DownsampleVisitor &cb) {
+      visit(*st, 0, [&](uint32_t k, const PointRef &p) {
+        DownsamplePoint d;
+        d.t = pointTime(*st, p);
+        for (int ch = 0; ch < SAMPLE3_CHANNELS; ch++) d.v[ch] = pointValue(p, GROUP_MEAN, ch);
+        return cb(k, d);
+      });
+    };
+    st->outCount = (uint32_t)lttbSelect(src, st->count, points, st->sel);
+    if (st->outCount == 0) {  // Mémoire insuffisante pour les moyennes de seaux
+      delete st;
+      return nullptr;
+    }
+  }
+
+  // t0 : temps du premier point émis (base des écarts)
+  if (st->outCount) {
+    visit(*st, srcIndex(*st, 0), [&](uint32_t, const PointRef &p) {
+      st->t0 = pointTime(*st, p);
+      return false;
+    });
+  }
+  st->prevT = st->t0;
+  return st;
+}
+
+void historyStreamFree(HistoryStream *st) {
+  delete st;
+}
+
+size_t historyStreamFill(HistoryStream &st, uint8_t *buf, size_t maxLen) {
+  size_t n = 0;
+  while (n < maxLen) {
+    if (st.pendOff == st.pendLen) {
+      if (st.pass == PASS_END) break;  // 0 octet : fin de la réponse
+      refill(st);
+      continue;
+    }
+    size_t k = st.pendLen - st.pendOff;
+    if (k > maxLen - n) k = maxLen - n;
+    memcpy(buf + n, st.pending + st.pendOff, k);
+    n += k;
+    st.pendOff += k;
+  }
+  return n;
+}
+
+uint32_t historyStreamEnd(const HistoryStream &st) {
+  return isRollup(st) ? 0 : st.first + st.count;
+}
+
+const char *historyStreamContentType(HistoryFormat fmt) {
+  return fmt == HISTORY_FORMAT_BINARY ? "application/octet-stream" : "application/json";
+}
@@ -0,0 +1,58 @@
+#include "json_writer.h"
+
+// "b1":{...},"b2":{...},"b3":{...} avec get(canal) -> valeur
+template <typename Get>
+static void writeGroups(JsonOut &w, Get get) {
+  for (const JsonField &f : SAMPLE3_JSON_FIELDS) {
+    w.raw(f.prefix, f.prefixLen);
+    w.fixed2(get(f.ch));
+  }
+  w.lit("}");
+}
+
+// ---------- JsonOut ----------
+void JsonOut::fixed2(float v) {
+  if (!fmtFixed2Ok(v)) {
+    lit("null");
+    return;
+  }
+  if (!reserve(FMT_FIXED2_MAX)) return;
+  len = fmtFixed2(buf + len, v) - buf;
+}
+
+void JsonOut::integer(int32_t v) {
+  if (!reserve(FMT_INT_MAX)) return;
+  len = fmtInt(buf + len, v) - buf;
+}
+
+void JsonOut::uinteger(uint32_t v) {
+  if (!reserve(FMT_INT_MAX)) return;
+  len = fmtUint(buf + len, v) - buf;
+}
+
+// ---------- Sérialisations ----------
+size_t jsonSample(char *out, size_t cap, const Sample3 &s, int32_t tOffset) {
+  JsonOut w(out, cap);
+  w.lit("{\"t\":");
+  w.uinteger((uint32_t)(s.t + tOffset));
+  w.lit(",");
+  writeGroups(w, [&](int ch) { return sample3Get(s, ch); });
+  w.lit("}");
+  return w.length();
+}
+
+size_t jsonRollup(char *out, size_t cap, const RollupBucket &b) {
+  JsonOut w(out, cap);
+  w.lit("{\"t\":");
+  w.uinteger(b.start);
+  w.lit(",\"n\":");
+  w.uinteger(b.samples);
+  w.lit(",");
+  writeGroups(w, [&](int ch) { return rollupMean(b.ch[ch]); });
+  w.lit(",\"min\":{");
+  writeGroups(w, [&](int ch) { return rollupMin(b.ch[ch]); });
+  w.lit("},\"max\":{");
+  writeGroups(w, [&](int ch) { return rollupMax(b.ch[ch]); });
+  w.lit("}}");
+  return w.length();
+}
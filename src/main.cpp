@@ -4,6 +4,10 @@
 #include <SPIFFS.h>
 #include "esp_sleep.h"
 #include "web_app.h"
+#include "storage.h"
+#include "pipeline.h"
+#include "clock_store.h"
+#include "date_format.h"
 #include <time.h>
 
 // ================= RS485 =================
@@ -28,7 +32,7 @@ const uint8_t OXYGEN_I2C_ADDR = 0x73;
 
 const unsigned long SLEEP_TIME_US = 60 * 60 * 1000000;  // 1 heure en µs
 const unsigned long WIFI_TIMEOUT_MS = 5 * 60 * 1000;   // 5 min avant extinction WiFi (auto)
-const char *CSV_FILE = "/data.csv";
+const uint32_t WIFI_SAMPLE_PERIOD_MS = 60 * 1000;      // Mesure en mode WiFi (tâche d'acquisition)
 
 // ================= FLAGS =================
 bool wifiActive = false;
@@ -46,47 +50,15 @@ void IRAM_ATTR handleButtonPress() {
 }
 
 // ================= SPIFFS CSV =================
-void writeCSV(float t1, float h1, float o2_val, float t2, float h2, float t3, float h3) {
-  // Créer structure Sample3 pour web_app
-  Sample3 sample;
-  sample.t = time(nullptr);  // Heure système (synchronisée via NTP quand WiFi actif)
-  sample.b1Temp = t1;
-  sample.b1Hum = h1;
-  sample.b1O2 = o2_val;
-  sample.b2Temp = t2;
-  sample.b2Hum = h2;
-  sample.b3Temp = t3;
-  sample.b3Hum = h3;
-  
-  // Si WiFi actif, utiliser web_app, sinon écrire directement
+void writeCSV(const Sample3 &sample) {
+  // Si WiFi actif, utiliser web_app (pipeline), sinon écrire directement
   if (wifiActive) {
     webPushSample(sample);
   } else {
-    // Écrire CSV directement
-    File file = SPIFFS.open(CSV_FILE, FILE_APPEND);
-    if (!file) {
-      Serial.println("[CSV] Erreur ouverture");
-      return;
+    // Écrire directement en flash (CSV + agrégats + archive), lot vidé avant le deep sleep
+    if (storagePersist(sample) && storageFlush()) {
+      Serial.println("[CSV] Donnees ecrites");
     }
-
-    file.print(sample.t);
-    file.print(",");
-    file.print(isnan(sample.b1Temp) ? "NAN" : String(sample.b1Temp, 2).c_str());
-    file.print(",");
-    file.print(isnan(sample.b1Hum) ? "NAN" : String(sample.b1Hum, 2).c_str());
-    file.print(",");
-    file.print(isnan(sample.b1O2) ? "NAN" : String(sample.b1O2, 2).c_str());
-    file.print(",");
-    file.print(isnan(sample.b2Temp) ? "NAN" : String(sample.b2Temp, 2).c_str());
-    file.print(",");
-    file.print(isnan(sample.b2Hum) ? "NAN" : String(sample.b2Hum, 2).c_str());
-    file.print(",");
-    file.print(isnan(sample.b3Temp) ? "NAN" : String(sample.b3Temp, 2).c_str());
-    file.print(",");
-    file.println(isnan(sample.b3Hum) ? "NAN" : String(sample.b3Hum, 2).c_str());
-
-    file.close();
-    Serial.println("[CSV] Donnees ecrites");
   }
 }
 uint16_t crc16(byte *data, int len) {
@@ -159,6 +131,65 @@ float readOxygen() {
   return raw / 100.0;
 }
 
+// ================= MESURE =================
+// Appelée par loop() (mode collecte) ou par la tâche d'acquisition du pipeline (mode WiFi),
+// jamais par les deux en même temps : seul l'appelant touche au bus RS485 et à l'I2C.
+bool readSample(Sample3 &sample) {
+  // -------- ACTIVATION SHT20 --------
+  sht20On();
+  delay(500);
+
+  // -------- LECTURE RS485 SHT20 --------
+  float t1 = readRegister(addresses[0], 0x0001);
+  delay(100);
+  float h1 = readRegister(addresses[0], 0x0002);
+  delay(100);
+  
+  float t2 = readRegister(addresses[1], 0x0001);
+  delay(100);
+  float h2 = readRegister(addresses[1], 0x0002);
+  delay(100);
+  
+  float t3 = readRegister(addresses[2], 0x0001);
+  delay(100);
+  float h3 = readRegister(addresses[2], 0x0002);
+
+  // -------- DESACTIVATION SHT20 --------
+  sht20Off();
+
+  // -------- LECTURE OXYGENE I2C --------
+  float o2 = readOxygen();
+
+  // -------- AFFICHER RESULTATS --------
+  Serial.print("SHT20-1: T=");
+  Serial.print(t1, 1);
+  Serial.print(" H=");
+  Serial.println(h1, 1);
+  
+  Serial.print("SHT20-2: T=");
+  Serial.print(t2, 1);
+  Serial.print(" H=");
+  Serial.println(h2, 1);
+  
+  Serial.print("SHT20-3: T=");
+  Serial.print(t3, 1);
+  Serial.print(" H=");
+  Serial.println(h3, 1);
+  
+  Serial.print("O2: ");
+  Serial.println(o2, 1);
+
+  sample.t = time(nullptr);  // Heure système (synchronisée via NTP quand WiFi actif)
+  sample.b1Temp = t1;
+  sample.b1Hum = h1;
+  sample.b1O2 = o2;
+  sample.b2Temp = t2;
+  sample.b2Hum = h2;
+  sample.b3Temp = t3;
+  sample.b3Hum = h3;
+  return true;
+}
+
 // ================= SETUP =================
 void setup() {
   Serial.begin(115200);
@@ -181,23 +212,22 @@ void setup() {
   Wire.begin();
   Wire.setClock(100000);
 
+  // Fuseau avant le stockage : agrégats journaliers sur minuit local dans tous les modes
+  dateSetTimezone();
+
   // Initialiser SPIFFS
   if (!SPIFFS.begin(true)) {
     Serial.println("[SPIFFS] Erreur init");
   } else {
     Serial.println("[SPIFFS] OK");
     
-    // Créer header CSV s'il n'existe pas
-    if (!SPIFFS.exists(CSV_FILE)) {
-      File f = SPIFFS.open(CSV_FILE, FILE_WRITE);
-      if (f) {
-        f.println("timestamp,temperature_bac1,humidity_bac1,oxygen_bac1,temperature_bac2,humidity_bac2,temperature_bac3,humidity_bac3");
-        f.close();
-        Serial.println("[CSV] Header cree");
-      }
-    }
+    // Header CSV + récupération des fins de fichiers déchirées
+    storageBegin();
   }
 
+  // Segments d'horloge : après une coupure, l'horloge reprend après le dernier temps enregistré
+  clockBegin();
+
   // Vérifier si bouton appuyé au démarrage
   if (buttonPressed || (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0)) {
     Serial.println("[BOUTON] Détecté au wakeup - WiFi ON");
@@ -233,6 +263,7 @@ void loop() {
       buttonPressed = false;
       delay(200);  // Debounce
       webInit();
+      pipelineStartSampler(readSample, WIFI_SAMPLE_PERIOD_MS);
       return;  // Rester en WiFi
     }
   }
@@ -252,60 +283,19 @@ void loop() {
       esp_deep_sleep_start();
     }
     
-    // Boucle WiFi légère
+    // Boucle WiFi légère : la collecte tourne dans la tâche d'acquisition (pipeline.h)
     delay(100);
-    return;  // Ne pas faire de collecte pendant WiFi
+    return;
   }
 
   // Mode collecte (sans WiFi)
   Serial.println("=== COLLECTE DE DONNEES ===");
 
-  // -------- ACTIVATION SHT20 --------
-  sht20On();
-  delay(500);
-
-  // -------- LECTURE RS485 SHT20 --------
-  float t1 = readRegister(addresses[0], 0x0001);
-  delay(100);
-  float h1 = readRegister(addresses[0], 0x0002);
-  delay(100);
-  
-  float t2 = readRegister(addresses[1], 0x0001);
-  delay(100);
-  float h2 = readRegister(addresses[1], 0x0002);
-  delay(100);
-  
-  float t3 = readRegister(addresses[2], 0x0001);
-  delay(100);
-  float h3 = readRegister(addresses[2], 0x0002);
-
-  // -------- DESACTIVATION SHT20 --------
-  sht20Off();
-
-  // -------- LECTURE OXYGENE I2C --------
-  float o2 = readOxygen();
-
-  // -------- AFFICHER RESULTATS --------
-  Serial.print("SHT20-1: T=");
-  Serial.print(t1, 1);
-  Serial.print(" H=");
-  Serial.println(h1, 1);
-  
-  Serial.print("SHT20-2: T=");
-  Serial.print(t2, 1);
-  Serial.print(" H=");
-  Serial.println(h2, 1);
-  
-  Serial.print("SHT20-3: T=");
-  Serial.print(t3, 1);
-  Serial.print(" H=");
-  Serial.println(h3, 1);
-  
-  Serial.print("O2: ");
-  Serial.println(o2, 1);
+  Sample3 sample;
+  readSample(sample);
 
   // -------- ENREGISTRER CSV --------
-  writeCSV(t1, h1, o2, t2, h2, t3, h3);
+  writeCSV(sample);
 
   // -------- SLEEP 5 MIN --------
   Serial.println("[SLEEP] Deep sleep 5 min...");
@@ -0,0 +1,216 @@
+#include "pipeline.h"
+#include "spsc_queue.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// ===== Tâches =====
+// Cœur 0 : pile WiFi/lwIP (priorités hautes) ; l'écriture flash y tourne en arrière-plan.
+// Cœur 1 : loop() Arduino, acquisition et diffusion.
+static const BaseType_t CORE_STORAGE = 0;
+static const BaseType_t CORE_APP = 1;
+
+static const UBaseType_t PRIO_STORAGE = 1;
+static const UBaseType_t PRIO_WEB = 2;
+static const UBaseType_t PRIO_SAMPLER = 3;  // Passe surtout son temps en attente (RS485, I2C)
+
+static const uint32_t STACK_STORAGE = 6144;  // SPIFFS + formatage CSV
+static const uint32_t STACK_WEB = 4096;
+static const uint32_t STACK_SAMPLER = 4096;
+
+static const uint32_t STOP_TIMEOUT_MS = 5000;  // Mesure en cours + vidage des files
+
+struct PipelineTask {
+  TaskHandle_t handle;
+  std::atomic<bool> done;  // Dernière boucle terminée, la tâche attend sa suppression
+};
+
+static PipelineTask samplerTask, storageTask, webTask;
+
+static SpscQueue<Sample3, PIPELINE_QUEUE_SIZE> storageQueue;
+static SpscQueue<Sample3, PIPELINE_QUEUE_SIZE> webQueue;
+
+static PipelineSink persistSink = nullptr;
+static PipelineSink publishSink = nullptr;
+static PipelineSource samplerSource = nullptr;
+static TickType_t samplerPeriod = 0;
+
+static std::atomic<bool> samplerStop{false};
+static std::atomic<bool> drainRequested{false};  // Plus aucun push : vider puis s'arrêter
+
+static std::atomic<uint32_t> samples{0};
+static std::atomic<uint32_t> persistMaxUs{0};
+static std::atomic<uint32_t> publishMaxUs{0};
+
+// ---------- Helpers ----------
+static void taskPark(PipelineTask &self) {
+  self.done.store(true);
+  for (;;) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // Supprimée par pipelineStop
+}
+
+static bool taskWait(PipelineTask &t, const char *name) {
+  uint32_t t0 = millis();
+  while (t.handle && !t.done.load()) {
+    if (millis() - t0 > STOP_TIMEOUT_MS) {
+      Serial.print("[PIPE] Arret trop long: ");
+      Serial.println(name);
+      return false;
+    }
+    delay(10);
+  }
+  return true;
+}
+
+static void taskEnd(PipelineTask &t) {
+  if (t.handle) vTaskDelete(t.handle);
+  t.handle = nullptr;
+}
+
+static void notify(PipelineTask &t) {
+  if (t.handle) xTaskNotifyGive(t.handle);
+}
+
+static void maxStore(std::atomic<uint32_t> &m, uint32_t v) {
+  if (v > m.load(std::memory_order_relaxed)) m.store(v, std::memory_order_relaxed);  // Un seul écrivain
+}
+
+// ---------- Consommateurs ----------
+static void consumerLoop(SpscQueue<Sample3, PIPELINE_QUEUE_SIZE> &q, PipelineSink sink,
+                         std::atomic<uint32_t> &maxUs, PipelineTask &self) {
+  for (;;) {
+    bool last = drainRequested.load();  // Lu avant de vider : aucun push ne peut suivre
+    Sample3 s;
+    while (q.pop(s)) {
+      uint32_t t0 = micros();
+      sink(s);
+      maxStore(maxUs, micros() - t0);
+    }
+    if (last) break;
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);  // Réveillé par pipelinePush / pipelineStop
+  }
+  taskPark(self);
+}
+
+static void storageMain(void *) {
+  consumerLoop(storageQueue, persistSink, persistMaxUs, storageTask);
+}
+
+static void webMain(void *) {
+  consumerLoop(webQueue, publishSink, publishMaxUs, webTask);
+}
+
+// ---------- Acquisition ----------
+static void samplerMain(void *) {
+  TickType_t next = xTaskGetTickCount();
+  while (!samplerStop.load()) {
+    Sample3 s;
+    if (samplerSource(s)) {
+      samples.fetch_add(1);
+      if (!pipelinePush(s)) Serial.println("[PIPE] File pleine, echantillon perdu");
+    }
+    next += samplerPeriod;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(next - now) <= 0) {
+      next = now;  // Mesure plus longue que la période : pas de rattrapage en rafale
+    } else {
+      ulTaskNotifyTake(pdTRUE, next - now);  // Réveil anticipé par pipelineStop
+    }
+  }
+  taskPark(samplerTask);
+}
+
+static bool taskStart(PipelineTask &t, TaskFunction_t fn, const char *name, uint32_t stack,
+                      UBaseType_t prio, BaseType_t core) {
+  t.done.store(false);
+  if (xTaskCreatePinnedToCore(fn, name, stack, nullptr, prio, &t.handle, core) != pdPASS) {
+    t.handle = nullptr;
+    Serial.print("[PIPE] Creation tache impossible: ");
+    Serial.println(name);
+    return false;
+  }
+  return true;
+}
+
+// ===== API =====
+void pipelineBegin(PipelineSink persist, PipelineSink publish) {
+  persistSink = persist;
+  publishSink = publish;
+  drainRequested.store(false);
+  taskStart(storageTask, storageMain, "storage", STACK_STORAGE, PRIO_STORAGE, CORE_STORAGE);
+  taskStart(webTask, webMain, "web", STACK_WEB, PRIO_WEB, CORE_APP);
+  Serial.println("[PIPE] Taches flash + reseau demarrees");
+}
+
+void pipelineStartSampler(PipelineSource acquire, uint32_t periodMs) {
+  samplerSource = acquire;
+  samplerPeriod = pdMS_TO_TICKS(periodMs);
+  samplerStop.store(false);
+  taskStart(samplerTask, samplerMain, "sampler", STACK_SAMPLER, PRIO_SAMPLER, CORE_APP);
+}
+
+bool pipelinePush(const Sample3 &s) {
+  // Sans tâche (création échouée) : traitement direct, comme avant le pipeline
+  bool ok = true;
+  if (storageTask.handle) {
+    ok = storageQueue.push(s);
+    notify(storageTask);
+  } else if (persistSink) {
+    persistSink(s);
+  }
+  if (webTask.handle) {
+    ok = webQueue.push(s) && ok;
+    notify(webTask);
+  } else if (publishSink) {
+    publishSink(s);
+  }
+  return ok;
+}
+
+bool pipelineStop() {
+  // 1) Plus de producteur : la mesure en cours se termine et est poussée
+  samplerStop.store(true);
+  notify(samplerTask);
+  bool parked = taskWait(samplerTask, "sampler");
+  if (parked) {
+    taskEnd(samplerTask);
+    // 2) Les consommateurs vident leur file puis s'arrêtent. Jamais tant que l'acquisition
+    // tourne : un push après leur sortie resterait en file sans consommateur.
+    drainRequested.store(true);
+    notify(storageTask);
+    notify(webTask);
+    if (taskWait(storageTask, "storage")) taskEnd(storageTask);
+    else parked = false;
+    if (taskWait(webTask, "web")) taskEnd(webTask);
+    else parked = false;
+  }
+  // Tâche bloquée (timeout) laissée en place : la supprimer en pleine écriture SPIFFS
+  // corromprait le fichier ; le deep sleep qui suit l'arrête proprement.
+
+  Serial.print("[PIPE] Arret, pertes flash/reseau: ");
+  Serial.print(storageQueue.dropped());
+  Serial.print("/");
+  Serial.print(webQueue.dropped());
+  Serial.print(", restants: ");
+  Serial.print(storageQueue.depth());
+  Serial.print("/");
+  Serial.println(webQueue.depth());
+  return parked;
+}
+
+static void queueStats(const SpscQueue<Sample3, PIPELINE_QUEUE_SIZE> &q, PipelineQueueStats &st) {
+  st.depth = q.depth();
+  st.highWater = q.highWater();
+  st.capacity = q.capacity();
+  st.pushed = q.pushed();
+  st.drops = q.dropped();
+}
+
+void pipelineStats(PipelineStats &st) {
+  queueStats(storageQueue, st.storage);
+  queueStats(webQueue, st.web);
+  st.samples = samples.load();
+  st.persistMaxUs = persistMaxUs.load();
+  st.publishMaxUs = publishMaxUs.load();
+}
@@ -0,0 +1,113 @@
+#include "rollup.h"
+#include "date_format.h"
+
+#include <math.h>
+
+static DateCache dayCache;  // Jour local courant (un seul écrivain d'agrégats par programme)
+
+// ---------- Helpers ----------
+static int16_t toCenti(float v) {
+  float c = roundf(v * 100.0f);
+  if (c > 32767.0f) c = 32767.0f;
+  if (c < -32767.0f) c = -32767.0f;
+  return (int16_t)c;
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ---------- Créneaux ----------
+uint32_t rollupPeriod(RollupTier tier) {
+  return (tier == ROLLUP_DAY) ? 86400UL : 3600UL;
+}
+
+uint32_t rollupBucketStart(RollupTier tier, uint32_t t) {
+  if (tier == ROLLUP_DAY) return (uint32_t)dateLocalMidnight(dayCache, (time_t)t);
+  return t - (t % rollupPeriod(tier));
+}
+
+// ---------- Agrégation incrémentale ----------
+void rollupReset(RollupBucket &b, uint32_t start) {
+  b.start = start;
+  b.samples = 0;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    b.ch[i].min = 32767;
+    b.ch[i].max = -32767;
+    b.ch[i].sum = 0;
+    b.ch[i].count = 0;
+  }
+}
+
+void rollupAdd(RollupBucket &b, const Sample3 &s) {
+  if (b.samples < 0xFFFF) b.samples++;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    float v = sample3Get(s, i);
+    if (!isfinite(v)) continue;
+    RollupChannel &c = b.ch[i];
+    if (c.count == 0xFFFF) continue;
+    int16_t cv = toCenti(v);
+    if (cv < c.min) c.min = cv;
+    if (cv > c.max) c.max = cv;
+    c.sum += cv;
+    c.count++;
+  }
+}
+
+float rollupMean(const RollupChannel &c) {
+  if (c.count == 0) return NAN;
+  return (float)c.sum / c.count / 100.0f;
+}
+
+float rollupMin(const RollupChannel &c) {
+  return c.count ? c.min / 100.0f : NAN;
+}
+
+float rollupMax(const RollupChannel &c) {
+  return c.count ? c.max / 100.0f : NAN;
+}
+
+// ---------- Format flash ----------
+void rollupEncode(const RollupBucket &b, uint8_t *out) {
+  put32(out, b.start);
+  put16(out + 4, b.samples);
+  uint8_t *p = out + 6;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    const RollupChannel &c = b.ch[i];
+    int32_t mean = c.count ? (int32_t)lroundf((float)c.sum / c.count) : 0;
+    put16(p, (uint16_t)mean);
+    put16(p + 2, (uint16_t)(c.count ? c.min : ROLLUP_NO_VALUE));
+    put16(p + 4, (uint16_t)c.max);
+    p += 6;
+  }
+}
+
+void rollupDecode(const uint8_t *in, RollupBucket &b) {
+  b.start = get32(in);
+  b.samples = get16(in + 4);
+  const uint8_t *p = in + 6;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    RollupChannel &c = b.ch[i];
+    c.min = (int16_t)get16(p + 2);
+    c.max = (int16_t)get16(p + 4);
+    c.count = c.min == ROLLUP_NO_VALUE ? 0 : 1;  // Moyenne stockée : somme d'une seule valeur
+    c.sum = c.count ? (int16_t)get16(p) : 0;
+    p += 6;
+  }
+}
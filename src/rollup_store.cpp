@@ -0,0 +1,186 @@
+#include "rollup_store.h"
+#include "clock_store.h"
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+static const uint32_t ROLLUP_RTC_MAGIC = 0x524F4C32;  // "ROL2"
+
+// Fichiers de l'ancien format (76 octets, créneaux en temps brut)
+static const char* const LEGACY_FILES[ROLLUP_TIER_COUNT] = {"/rollup_h.bin", "/rollup_d.bin"};
+
+// ===== Créneaux ouverts (RTC) =====
+RTC_DATA_ATTR static uint32_t rtcMagic = 0;
+RTC_DATA_ATTR static RollupBucket rtcOpen[ROLLUP_TIER_COUNT];
+
+// ===== Verrou =====
+// Écrivain : tâche flash du pipeline (rollupStorePush, rotation) ; lecteurs : tâche AsyncTCP
+// (/api/history?resolution=hour|day). Le verrou couvre le créneau ouvert, la rotation et chaque
+// lecture : un lecteur ne voit jamais un créneau à moitié remis à zéro ni des fichiers en cours
+// de renommage. Les lectures sont bornées par appel (réponses découpées).
+static SemaphoreHandle_t rollupLock = nullptr;
+
+// Enregistrements retirés par rotation depuis le démarrage : index absolus (rollupStoreRange)
+// stables d'un appel à l'autre même si une rotation a lieu entre deux morceaux d'une réponse
+static size_t dropped[ROLLUP_TIER_COUNT] = {};
+
+static void rollupLockTake() {
+  if (rollupLock) xSemaphoreTake(rollupLock, portMAX_DELAY);
+}
+
+static void rollupLockGive() {
+  if (rollupLock) xSemaphoreGive(rollupLock);
+}
+
+static void ensureOpenState() {
+  if (rtcMagic == ROLLUP_RTC_MAGIC) return;
+  // Mise sous tension (RTC perdue) : repartir de créneaux vides
+  for (int i = 0; i < ROLLUP_TIER_COUNT; i++) rollupReset(rtcOpen[i], 0);
+  rtcMagic = ROLLUP_RTC_MAGIC;
+}
+
+// ===== Générations =====
+static size_t recordCount(const char *path) {
+  if (!SPIFFS.exists(path)) return 0;
+  File f = SPIFFS.open(path, FILE_READ);
+  if (!f) return 0;
+  size_t n = f.size() / ROLLUP_RECORD_SIZE;
+  f.close();
+  return n;
+}
+
+// Le fichier courant plein devient l'ancienne génération ; l'appel suivant repart d'un fichier vide
+static void rotate(RollupTier tier) {
+  dropped[tier] += recordCount(ROLLUP_OLD_FILES[tier]);
+  if (SPIFFS.exists(ROLLUP_OLD_FILES[tier])) SPIFFS.remove(ROLLUP_OLD_FILES[tier]);
+  if (!SPIFFS.rename(ROLLUP_FILES[tier], ROLLUP_OLD_FILES[tier])) {
+    Serial.println("[ROLLUP] Erreur rotation");
+    SPIFFS.remove(ROLLUP_FILES[tier]);
+  }
+}
+
+static void appendRecord(RollupTier tier, const RollupBucket &b) {
+  if (recordCount(ROLLUP_FILES[tier]) >= ROLLUP_GEN_RECORDS[tier]) rotate(tier);
+
+  File f = SPIFFS.open(ROLLUP_FILES[tier], FILE_APPEND);
+  if (!f) {
+    Serial.println("[ROLLUP] Erreur ouverture");
+    return;
+  }
+  uint8_t rec[ROLLUP_RECORD_SIZE];
+  rollupEncode(b, rec);
+  f.write(rec, sizeof(rec));
+  f.close();
+}
+
+// Parcourt les enregistrements fermés à partir de l'index absolu first (ancienne génération puis
+// courante). Retourne false si cb a demandé l'arrêt. Sous verrou.
+static bool readClosed(RollupTier tier, size_t first,
+                       const std::function<bool(size_t, const RollupBucket &)> &cb) {
+  const char *paths[2] = {ROLLUP_OLD_FILES[tier], ROLLUP_FILES[tier]};
+  size_t base = dropped[tier];
+  uint8_t rec[ROLLUP_RECORD_SIZE];
+  RollupBucket b;
+
+  for (int g = 0; g < 2; g++) {
+    size_t n = recordCount(paths[g]);
+    if (first >= base + n) {
+      base += n;
+      continue;
+    }
+    File f = SPIFFS.open(paths[g], FILE_READ);
+    if (!f) {
+      base += n;
+      continue;
+    }
+    size_t index = first > base ? first : base;
+    f.seek((index - base) * ROLLUP_RECORD_SIZE);
+    while (index < base + n && f.read(rec, sizeof(rec)) == sizeof(rec)) {
+      rollupDecode(rec, b);
+      if (!cb(index, b)) {
+        f.close();
+        return false;
+      }
+      index++;
+    }
+    f.close();
+    base += n;
+  }
+  return true;
+}
+
+static size_t closedCount(RollupTier tier) {
+  return recordCount(ROLLUP_OLD_FILES[tier]) + recordCount(ROLLUP_FILES[tier]);
+}
+
+// ---------- Public API ----------
+void rollupStoreBegin() {
+  if (!rollupLock) rollupLock = xSemaphoreCreateMutex();
+  for (int i = 0; i < ROLLUP_TIER_COUNT; i++) {
+    if (!SPIFFS.exists(LEGACY_FILES[i])) continue;
+    SPIFFS.remove(LEGACY_FILES[i]);
+    Serial.println("[ROLLUP] Ancien fichier d'agregats supprime");
+  }
+}
+
+void rollupStorePush(const Sample3 &s) {
+  uint32_t t = clockReal(s.t);
+  rollupLockTake();
+  ensureOpenState();
+
+  for (int i = 0; i < ROLLUP_TIER_COUNT; i++) {
+    RollupTier tier = (RollupTier)i;
+    RollupBucket &open = rtcOpen[i];
+    uint32_t start = rollupBucketStart(tier, t);
+
+    if (open.samples > 0 && open.start != start) {
+      appendRecord(tier, open);  // Créneau terminé -> flash
+      rollupReset(open, start);
+    } else if (open.samples == 0) {
+      open.start = start;
+    }
+    rollupAdd(open, s);
+  }
+  rollupLockGive();
+}
+
+void rollupStoreForEach(RollupTier tier, size_t maxRecords,
+                        const std::function<void(const RollupBucket &)> &cb) {
+  rollupLockTake();
+  ensureOpenState();
+  const RollupBucket &open = rtcOpen[tier];
+  size_t wantClosed = maxRecords;
+  if (open.samples > 0 && wantClosed > 0) wantClosed--;
+
+  size_t closed = closedCount(tier);
+  size_t first = dropped[tier] + ((closed > wantClosed) ? closed - wantClosed : 0);
+  readClosed(tier, first, [&](size_t, const RollupBucket &b) {
+    cb(b);
+    return true;
+  });
+
+  if (open.samples > 0 && maxRecords > 0) cb(open);
+  rollupLockGive();
+}
+
+void rollupStoreRange(RollupTier tier, size_t &first, size_t &end) {
+  rollupLockTake();
+  ensureOpenState();
+  first = dropped[tier];
+  end = first + closedCount(tier) + (rtcOpen[tier].samples > 0 ? 1 : 0);
+  rollupLockGive();
+}
+
+void rollupStoreForEachFrom(RollupTier tier, size_t first,
+                            const std::function<bool(size_t, const RollupBucket &)> &cb) {
+  rollupLockTake();
+  ensureOpenState();
+  size_t total = dropped[tier] + closedCount(tier);
+  bool more = first >= total || readClosed(tier, first, cb);
+
+  // Le créneau ouvert suit immédiatement le dernier créneau fermé
+  if (more && first <= total && rtcOpen[tier].samples > 0) cb(total, rtcOpen[tier]);
+  rollupLockGive();
+}
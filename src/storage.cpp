@@ -0,0 +1,31 @@
+#include "storage.h"
+#include "csv_log.h"
+#include "rollup_store.h"
+#include "archive_store.h"
+
+#include <Arduino.h>
+#include <unistd.h>
+
+static const char* SPIFFS_BASE = "/spiffs";  // Point de montage VFS (SPIFFS.begin par défaut)
+
+void storageBegin() {
+  csvLogBegin();
+  archiveStoreBegin();
+  rollupStoreBegin();
+}
+
+bool storagePersist(const Sample3 &s) {
+  bool ok = csvLogAppend(s);
+  rollupStorePush(s);
+  archiveStorePush(s);
+  return ok;
+}
+
+bool storageFlush() {
+  return csvLogFlush();
+}
+
+bool storageTruncate(const char *path, size_t len) {
+  String full = String(SPIFFS_BASE) + path;
+  return truncate(full.c_str(), len) == 0;
+}
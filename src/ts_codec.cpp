@@ -0,0 +1,272 @@
+#include "ts_codec.h"
+
+#include <math.h>
+#include <string.h>
+
+static const uint32_t PAYLOAD_BITS = (TS_BLOCK_SIZE - TS_BLOCK_HEADER) * 8;
+static const int32_t VALUE_NAN = INT32_MIN;        // Sentinelle "valeur absente"
+static const float VALUE_LIMIT = 2000000000.0f;    // Borne des centièmes quantifiés
+
+// ---------- Helpers ----------
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t zigzag(uint32_t d) {
+  return (d << 1) ^ (uint32_t)((int32_t)d >> 31);
+}
+
+static uint32_t unzigzag(uint32_t z) {
+  return (z >> 1) ^ (uint32_t)(-(int32_t)(z & 1));
+}
+
+static int32_t quantize(float v) {
+  if (!isfinite(v)) return VALUE_NAN;
+  float c = roundf(v * 100.0f);
+  if (c > VALUE_LIMIT) c = VALUE_LIMIT;
+  if (c < -VALUE_LIMIT) c = -VALUE_LIMIT;
+  return (int32_t)c;
+}
+
+// CRC-16/MODBUS sur magic/count/t0/bitLen + flux utilisé
+static uint16_t blockCrc(const uint8_t *blk, uint32_t bitLen) {
+  uint16_t crc = 0xFFFF;
+  size_t payload = (bitLen + 7) / 8;
+  for (size_t i = 0; i < TS_BLOCK_HEADER + payload; i++) {
+    if (i >= 10 && i < TS_BLOCK_HEADER) continue;  // crc, flags, réservé
+    crc ^= blk[i];
+    for (int b = 0; b < 8; b++)
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xA001 : 0);
+  }
+  return crc;
+}
+
+// ===== Encodeur =====
+void TsBlockEncoder::begin(uint8_t *block) {
+  blk = block;
+  memset(blk, 0, TS_BLOCK_SIZE);
+  put16(blk, TS_BLOCK_MAGIC);
+  bitPos = 0;
+  n = 0;
+  prevT = 0;
+  prevDelta = 0;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) prevVal[i] = 0;
+  commit();
+}
+
+bool TsBlockEncoder::resume(uint8_t *block) {
+  TsBlockDecoder dec;
+  if (!dec.begin(block) || dec.sealed()) return false;
+  Sample3 s;
+  while (dec.next(s)) {}
+  if (dec.idx != dec.n) return false;
+
+  blk = block;
+  bitPos = dec.bitPos;
+  n = dec.n;
+  prevT = dec.prevT;
+  prevDelta = dec.prevDelta;
+  memcpy(prevVal, dec.prevVal, sizeof(prevVal));
+  return true;
+}
+
+bool TsBlockEncoder::writeBits(uint32_t v, int bits) {
+  if (bitPos + bits > PAYLOAD_BITS) return false;
+  uint8_t *p = blk + TS_BLOCK_HEADER;
+  while (bits > 0) {
+    int off = bitPos & 7;
+    int room = 8 - off;
+    int take = bits < room ? bits : room;
+    uint8_t chunk = (uint8_t)((v >> (bits - take)) & ((1u << take) - 1));
+    uint8_t mask = (uint8_t)(((1u << take) - 1) << (room - take));
+    uint8_t &b = p[bitPos >> 3];
+    b = (uint8_t)((b & ~mask) | (chunk << (room - take)));
+    bitPos += take;
+    bits -= take;
+  }
+  return true;
+}
+
+bool TsBlockEncoder::writeTime(uint32_t t) {
+  if (n == 0) {
+    put32(blk + 4, t);
+    prevT = t;
+    prevDelta = 0;
+    return true;
+  }
+  uint32_t delta = t - prevT;
+  uint32_t zz = zigzag(delta - (uint32_t)prevDelta);
+  bool ok;
+  if (zz == 0) ok = writeBits(0x0, 1);
+  else if (zz < 128) ok = writeBits(0x2, 2) && writeBits(zz, 7);
+  else if (zz < 512) ok = writeBits(0x6, 3) && writeBits(zz, 9);
+  else if (zz < 4096) ok = writeBits(0xE, 4) && writeBits(zz, 12);
+  else ok = writeBits(0xF, 4) && writeBits(zz, 32);
+  prevT = t;
+  prevDelta = (int32_t)delta;
+  return ok;
+}
+
+bool TsBlockEncoder::writeValue(int ch, float v) {
+  int32_t q = quantize(v);
+  int32_t prev = prevVal[ch];
+  prevVal[ch] = q;
+
+  if (q == VALUE_NAN) return (prev == VALUE_NAN) ? writeBits(0x0, 1) : writeBits(0x1F, 5);
+  if (prev == VALUE_NAN) return writeBits(0x1E, 5) && writeBits((uint32_t)q, 32);
+
+  uint32_t zz = zigzag((uint32_t)q - (uint32_t)prev);
+  if (zz == 0) return writeBits(0x0, 1);
+  if (zz < 64) return writeBits(0x2, 2) && writeBits(zz, 6);
+  if (zz < 1024) return writeBits(0x6, 3) && writeBits(zz, 10);
+  if (zz < 65536) return writeBits(0xE, 4) && writeBits(zz, 16);
+  return writeBits(0x1E, 5) && writeBits((uint32_t)q, 32);
+}
+
+bool TsBlockEncoder::append(const Sample3 &s) {
+  if (blk[12] & TS_BLOCK_SEALED) return false;
+  if (n == 0xFFFF) return false;
+
+  // Sauvegarde pour annuler un échantillon qui ne tient pas
+  uint32_t savedPos = bitPos;
+  uint32_t savedT = prevT;
+  int32_t savedDelta = prevDelta;
+  int32_t savedVal[SAMPLE3_CHANNELS];
+  memcpy(savedVal, prevVal, sizeof(savedVal));
+
+  bool ok = writeTime((uint32_t)s.t);
+  for (int i = 0; ok && i < SAMPLE3_CHANNELS; i++) ok = writeValue(i, sample3Get(s, i));
+
+  if (!ok) {
+    bitPos = savedPos;
+    prevT = savedT;
+    prevDelta = savedDelta;
+    memcpy(prevVal, savedVal, sizeof(prevVal));
+    return false;
+  }
+  n++;
+  return true;
+}
+
+void TsBlockEncoder::commit() {
+  put16(blk + 2, n);
+  put16(blk + 8, (uint16_t)bitPos);
+  put16(blk + 10, blockCrc(blk, bitPos));
+}
+
+void TsBlockEncoder::seal() {
+  commit();
+  blk[12] |= TS_BLOCK_SEALED;
+}
+
+// ===== Décodeur =====
+bool TsBlockDecoder::begin(const uint8_t *block) {
+  blk = block;
+  if (get16(blk) != TS_BLOCK_MAGIC) return false;
+  n = get16(blk + 2);
+  bitLen = get16(blk + 8);
+  if (bitLen > PAYLOAD_BITS) return false;
+  if (get16(blk + 10) != blockCrc(blk, bitLen)) return false;
+
+  bitPos = 0;
+  idx = 0;
+  prevT = 0;
+  prevDelta = 0;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) prevVal[i] = 0;
+  return true;
+}
+
+bool TsBlockDecoder::sealed() const {
+  return (blk[12] & TS_BLOCK_SEALED) != 0;
+}
+
+uint32_t TsBlockDecoder::firstTime() const {
+  return get32(blk + 4);
+}
+
+bool TsBlockDecoder::readBits(int bits, uint32_t &v) {
+  if (bitPos + bits > bitLen) return false;
+  const uint8_t *p = blk + TS_BLOCK_HEADER;
+  v = 0;
+  while (bits > 0) {
+    int off = bitPos & 7;
+    int room = 8 - off;
+    int take = bits < room ? bits : room;
+    uint8_t b = p[bitPos >> 3];
+    v = (v << take) | ((b >> (room - take)) & ((1u << take) - 1));
+    bitPos += take;
+    bits -= take;
+  }
+  return true;
+}
+
+// Nombre de '1' avant le '0' terminal (maxOnes : code sans '0' terminal)
+int TsBlockDecoder::readPrefix(int maxOnes) {
+  int ones = 0;
+  uint32_t bit;
+  while (ones < maxOnes) {
+    if (!readBits(1, bit)) return -1;
+    if (!bit) break;
+    ones++;
+  }
+  return ones;
+}
+
+bool TsBlockDecoder::next(Sample3 &s) {
+  if (idx >= n) return false;
+
+  // Timestamp
+  if (idx == 0) {
+    prevT = firstTime();
+    prevDelta = 0;
+  } else {
+    static const int TIME_BITS[] = {0, 7, 9, 12, 32};
+    int code = readPrefix(4);
+    if (code < 0) return false;
+    uint32_t zz = 0;
+    if (code > 0 && !readBits(TIME_BITS[code], zz)) return false;
+    uint32_t delta = (uint32_t)prevDelta + unzigzag(zz);
+    prevT += delta;
+    prevDelta = (int32_t)delta;
+  }
+  s.t = (time_t)prevT;
+
+  // Canaux
+  static const int VALUE_BITS[] = {0, 6, 10, 16};
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    int code = readPrefix(5);
+    if (code < 0) return false;
+    uint32_t raw = 0;
+    if (code == 0) {
+      // Valeur inchangée (ou toujours absente)
+    } else if (code <= 3) {
+      if (!readBits(VALUE_BITS[code], raw)) return false;
+      prevVal[i] = (int32_t)((uint32_t)prevVal[i] + unzigzag(raw));
+    } else if (code == 4) {
+      if (!readBits(32, raw)) return false;
+      prevVal[i] = (int32_t)raw;
+    } else {
+      prevVal[i] = VALUE_NAN;
+    }
+    sample3Set(s, i, (prevVal[i] == VALUE_NAN) ? NAN : prevVal[i] / 100.0f);
+  }
+
+  idx++;
+  return true;
+}
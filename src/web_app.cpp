@@ -1,11 +1,26 @@
 #include "web_app.h"
 #include "web_page.h"
+#include "web_assets.h"
+#include "rollup_store.h"
+#include "csv_log.h"
+#include "storage.h"
+#include "history_ring.h"
+#include "csv_export.h"
+#include "csv_query.h"
+#include "json_writer.h"
+#include "history_stream.h"
+#include "pipeline.h"
+#include "clock_store.h"
 
 #include <WiFi.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 #include <SPIFFS.h>
 #include <time.h>
+#include <memory>
+#include <new>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // ===== WiFi AP =====
 static const char* ap_ssid = "PolyGreen";
@@ -26,166 +41,197 @@ static AsyncEventSource events("/events");
 // ===== Access flag (NFC) =====
 static volatile bool g_accessOk = true;  // true par défaut (pas de NFC pour l'instant)
 
-// ===== CSV single file =====
-static const char* CSV_DATA = "/data.csv";
-
-// ===== History RAM =====
-static const size_t HISTORY_SIZE = 300;
-static Sample3 historyBuf[HISTORY_SIZE];
-static size_t histCount = 0;
-static size_t histHead = 0;
+// ===== History RAM (voir history_ring.h) =====
+static const size_t ROLLUP_MAX_POINTS = 400;  // Points max renvoyés par niveau d'agrégat
+static const uint32_t SSE_REPLAY_MAX = 24;     // Échantillons rejoués max (file SSE du client limitée)
 static bool timeSynced = false;  // Flag: heure synchronisée?
-static time_t timeOffsetSeconds = 0;  // Offset appliqué aux anciennes données
+static uint32_t bootId = 0;  // Aléatoire par démarrage : les ETag ne survivent pas au reboot
 
 // ---------- Helpers ----------
-static void pushHistory(const Sample3& s) {
-  historyBuf[histHead] = s;
-  histHead = (histHead + 1) % HISTORY_SIZE;
-  if (histCount < HISTORY_SIZE) histCount++;
-}
-
 static void loadHistoryFromCSV() {
-  // Charger les dernières lignes du CSV dans l'historique RAM
-  if (!SPIFFS.exists(CSV_DATA)) return;
-  
-  File file = SPIFFS.open(CSV_DATA, FILE_READ);
-  if (!file) return;
-  
-  // Lire toutes les lignes
-  while (file.available()) {
-    String line = file.readStringUntil('\n');
-    if (line.length() == 0) continue;
-    
-    // Skip header
-    if (line.indexOf("timestamp") != -1 || line.indexOf("date_time") != -1) continue;
-    
-    // Parser: timestamp/date_time,t1,h1,o2,t2,h2,t3,h3
-    int idx = 0;
-    float vals[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-    
-    // Premier champ: peut être "YYYY-MM-DD HH:MM:SS" ou un nombre (old format)
-    int comma = line.indexOf(',', idx);
-    if (comma == -1) comma = line.length();
-    
-    String firstField = line.substring(idx, comma);
-    
-    // Vérifier si c'est un format date ou timestamp
-    time_t t = 0;
-    if (firstField.indexOf(':') != -1) {
-      // Format date/heure: YYYY-MM-DD HH:MM:SS (ignorer, utiliser offset)
-      t = 0;  // Will be set later
-    } else {
-      // Ancien format: timestamp en secondes
-      t = (time_t)firstField.toInt();
-    }
-    
-    idx = comma + 1;
-    
-    // Parser le reste des valeurs
-    for (int i = 0; i < 7; i++) {
-      comma = line.indexOf(',', idx);
-      if (comma == -1) comma = line.length();
-      
-      String val = line.substring(idx, comma);
-      if (val != "NAN" && val.length() > 0) {
-        vals[i+1] = val.toFloat();
-      } else {
-        vals[i+1] = NAN;
-      }
-      idx = comma + 1;
-    }
-    
-    Sample3 s;
-    s.t = t;
-    s.b1Temp = vals[1];
-    s.b1Hum = vals[2];
-    s.b1O2 = vals[3];
-    s.b2Temp = vals[4];
-    s.b2Hum = vals[5];
-    s.b3Temp = vals[6];
-    s.b3Hum = vals[7];
-    
-    pushHistory(s);
-  }
-  
-  file.close();
+  // Charger les lignes valides du CSV dans l'historique RAM (lignes déchirées ignorées)
+  csvLogForEach([](const Sample3 &s) { historyPush(s); });
+
   Serial.print("[WEB] Historique charge: ");
-  Serial.print(histCount);
+  Serial.print(historyCount());
   Serial.println(" donnees");
 }
 
-static String safeNum(float v) {
-  if (!isfinite(v)) return "null";
-  String s = String(v, 2);
-  return s;
+// ===== Dernier échantillon pré-sérialisé =====
+// Reconstruit une fois par échantillon (ou changement d'heure) au lieu d'une sérialisation par
+// requête. Deux écrivains (tâche réseau du pipeline, /api/settime) : reconstruction sous mutex.
+// Les lecteurs en prennent une copie sous le même mutex : une réponse ou un événement SSE
+// encore en cours d'envoi ne pointe jamais dans le tampon partagé.
+struct LatestSnapshot {
+  char json[JSON_SAMPLE_MAX];  // "{}" si historique vide, terminé par '\0'
+  char etag[24];               // "bootId-version"
+};
+static LatestSnapshot latestSnap;
+static uint32_t latestVersion = 0;
+static SemaphoreHandle_t latestLock = nullptr;
+
+static void latestSnapshot(LatestSnapshot &out) {
+  xSemaphoreTake(latestLock, portMAX_DELAY);
+  out = latestSnap;
+  xSemaphoreGive(latestLock);
 }
 
-static String latestJson() {
-  if (histCount == 0) return "{}";
-  size_t idx = (histHead + HISTORY_SIZE - 1) % HISTORY_SIZE;
-  const Sample3 &s = historyBuf[idx];
-
-  String j = "{";
-  j += "\"t\":" + String(s.t + timeOffsetSeconds) + ",";
-  j += "\"b1\":{\"tempC\":" + safeNum(s.b1Temp) + ",\"humPct\":" + safeNum(s.b1Hum) + ",\"o2Pct\":" + safeNum(s.b1O2) + "},";
-  j += "\"b2\":{\"tempC\":" + safeNum(s.b2Temp) + ",\"humPct\":" + safeNum(s.b2Hum) + "},";
-  j += "\"b3\":{\"tempC\":" + safeNum(s.b3Temp) + ",\"humPct\":" + safeNum(s.b3Hum) + "}";
-  j += "}";
-  return j;
+static void latestRebuild() {
+  xSemaphoreTake(latestLock, portMAX_DELAY);
+  LatestSnapshot &snap = latestSnap;
+  Sample3 s;
+  size_t n = historyLatest(s) ? jsonSample(snap.json, sizeof(snap.json) - 1, s, clockOffset(s.t)) : 0;
+  if (n == 0) {
+    strcpy(snap.json, "{}");
+    n = 2;
+  }
+  snap.json[n] = '\0';
+  latestVersion++;
+  snprintf(snap.etag, sizeof(snap.etag), "\"%08lx-%lu\"", (unsigned long)bootId, (unsigned long)latestVersion);
+  xSemaphoreGive(latestLock);
 }
 
-static String historyJson() {
-  String j = "[";
-  for (size_t i = 0; i < histCount; i++) {
-    size_t idx = (histHead + HISTORY_SIZE - histCount + i) % HISTORY_SIZE;
-    const Sample3 &s = historyBuf[idx];
-    if (i) j += ",";
-    j += "{";
-    j += "\"t\":" + String(s.t + timeOffsetSeconds) + ",";
-    j += "\"b1\":{\"tempC\":" + safeNum(s.b1Temp) + ",\"humPct\":" + safeNum(s.b1Hum) + ",\"o2Pct\":" + safeNum(s.b1O2) + "},";
-    j += "\"b2\":{\"tempC\":" + safeNum(s.b2Temp) + ",\"humPct\":" + safeNum(s.b2Hum) + "},";
-    j += "\"b3\":{\"tempC\":" + safeNum(s.b3Temp) + ",\"humPct\":" + safeNum(s.b3Hum) + "}";
-    j += "}";
+// ?resolution=raw|hour|day, ?format=json|columns|bin (ou Accept: application/octet-stream),
+// ?since=<epoch> : points postérieurs seulement, ?points=N : sous-échantillonnage LTTB.
+// ETag + If-None-Match -> 304.
+static void sendHistory(AsyncWebServerRequest *req) {
+  String res = req->hasParam("resolution") ? req->getParam("resolution")->value() : String("raw");
+  HistoryResolution resolution;
+  if (res == "raw") resolution = HISTORY_RAW;
+  else if (res == "hour") resolution = HISTORY_HOUR;
+  else if (res == "day") resolution = HISTORY_DAY;
+  else {
+    req->send(400, "application/json", "{\"error\":\"resolution must be raw, hour or day\"}");
+    return;
+  }
+
+  String fmt;
+  if (req->hasParam("format")) fmt = req->getParam("format")->value();
+  else if (req->hasHeader("Accept") && req->getHeader("Accept")->value().indexOf("application/octet-stream") >= 0) fmt = "bin";
+  else fmt = "json";
+  HistoryFormat format;
+  if (fmt == "json") format = HISTORY_FORMAT_ROWS;
+  else if (fmt == "columns") format = HISTORY_FORMAT_COLUMNS;
+  else if (fmt == "bin") format = HISTORY_FORMAT_BINARY;
+  else {
+    req->send(400, "application/json", "{\"error\":\"format must be json, columns or bin\"}");
+    return;
+  }
+
+  // Contenu inchangé tant que ni le ring (séquence), ni les segments d'horloge, ni le boot ne changent
+  EpochTable epochs;
+  clockEpochs(epochs);
+  char etag[40];
+  snprintf(etag, sizeof(etag), "\"%08lx-%lu-%lu\"", (unsigned long)bootId,
+           (unsigned long)historySeq(), (unsigned long)epochs.version);
+  if (req->hasHeader("If-None-Match") && req->getHeader("If-None-Match")->value() == etag) {
+    AsyncWebServerResponse *r = req->beginResponse(304);
+    r->addHeader("ETag", etag);
+    req->send(r);
+    return;
+  }
+
+  long points = req->hasParam("points") ? req->getParam("points")->value().toInt() : 0;
+  if (points < 0 || points > HISTORY_POINTS_MAX) {
+    req->send(400, "application/json", "{\"error\":\"points must be between 0 and 500\"}");
+    return;
+  }
+
+  uint32_t since = req->hasParam("since") ? (uint32_t)req->getParam("since")->value().toInt() : 0;
+  HistoryStream *raw = historyStreamCreate(resolution, format, epochs, ROLLUP_MAX_POINTS,
+                                           since, (uint16_t)points);
+  if (!raw) {
+    req->send(503, "application/json", "{\"error\":\"out of memory\"}");
+    return;
   }
-  j += "]";
-  return j;
+  // Brut : id SSE du dernier point, le client ignore ensuite les échantillons live déjà reçus
+  char end[12] = "";
+  if (resolution == HISTORY_RAW) snprintf(end, sizeof(end), "%lu", (unsigned long)historyStreamEnd(*raw));
+  std::shared_ptr<HistoryStream> st(raw, historyStreamFree);  // Libéré avec la réponse
+  AsyncWebServerResponse *r = req->beginChunkedResponse(historyStreamContentType(format), [st](uint8_t *buf, size_t maxLen, size_t) {
+    return historyStreamFill(*st, buf, maxLen);
+  });
+  r->addHeader("ETag", etag);
+  r->addHeader("Cache-Control", "no-cache");  // Revalidation systématique (304 si inchangé)
+  if (end[0]) r->addHeader("X-History-End", end);
+  req->send(r);
 }
 
-static bool requireAuth(AsyncWebServerRequest *request) {
-  if (!request->authenticate(auth_user, auth_pass)) {
-    request->requestAuthentication();
-    return false;
+// /api/query?field=b1Temp&agg=avg|min|max|count&bucket=1h&from=&to=&gt=&lt= : agrégats par
+// créneau calculés en une passe sur le journal flash (voir csv_query.h)
+static void sendQuery(AsyncWebServerRequest *req) {
+  int ch;
+  if (!req->hasParam("field") || !csvQueryField(req->getParam("field")->value().c_str(), ch)) {
+    req->send(400, "application/json", "{\"error\":\"field must be b1Temp, b1Hum, b1O2, b2Temp, b2Hum, b3Temp or b3Hum\"}");
+    return;
   }
-  return true;
+  QueryAgg agg = QUERY_AVG;
+  if (req->hasParam("agg") && !csvQueryAgg(req->getParam("agg")->value().c_str(), agg)) {
+    req->send(400, "application/json", "{\"error\":\"agg must be avg, min, max or count\"}");
+    return;
+  }
+  uint32_t bucket = 3600;
+  if (req->hasParam("bucket") && !csvQueryBucket(req->getParam("bucket")->value().c_str(), bucket)) {
+    req->send(400, "application/json", "{\"error\":\"bucket must be like 15m, 1h or 1d (>= 1m)\"}");
+    return;
+  }
+
+  float gt = -INFINITY, lt = INFINITY;
+  if ((req->hasParam("gt") && !csvQueryValue(req->getParam("gt")->value().c_str(), gt)) ||
+      (req->hasParam("lt") && !csvQueryValue(req->getParam("lt")->value().c_str(), lt))) {
+    req->send(400, "application/json", "{\"error\":\"gt and lt must be numbers\"}");
+    return;
+  }
+
+  CsvQuery *raw = new (std::nothrow) CsvQuery;
+  if (!raw) {
+    req->send(503, "application/json", "{\"error\":\"out of memory\"}");
+    return;
+  }
+  raw->ch = ch;
+  raw->agg = agg;
+  raw->bucket = bucket;
+  raw->gt = gt;
+  raw->lt = lt;
+  uint32_t from = req->hasParam("from") ? (uint32_t)req->getParam("from")->value().toInt() : 0;
+  uint32_t to = req->hasParam("to") ? (uint32_t)req->getParam("to")->value().toInt() : 0xFFFFFFFF;
+  EpochTable epochs;
+  clockEpochs(epochs);
+  csvQueryBegin(*raw, epochs, from, to);
+  std::shared_ptr<CsvQuery> q(raw);  // Fichier fermé avec la réponse
+
+  AsyncWebServerResponse *r = req->beginChunkedResponse("application/json", [q](uint8_t *buf, size_t maxLen, size_t) {
+    size_t n = csvQueryFill(*q, buf, maxLen);
+    return n == CSV_SCAN_AGAIN ? (size_t)RESPONSE_TRY_AGAIN : n;
+  });
+  req->send(r);
 }
 
-static void ensureCsvHeader() {
-  if (!SPIFFS.exists(CSV_DATA)) {
-    File f = SPIFFS.open(CSV_DATA, FILE_WRITE);
-    if (f) {
-      f.println("date_time,temperature_bac1,humidity_bac1,oxygen_bac1,temperature_bac2,humidity_bac2,temperature_bac3,humidity_bac3");
-      f.close();
-    }
+#if WEB_ASSETS_GZ
+// Ressource précompressée : 304 si l'ETag correspond ; cache permanent si l'URL porte la bonne
+// version (?v=), sinon revalidation à chaque visite (la page elle-même)
+static void sendAsset(AsyncWebServerRequest *req, const WebAsset &a) {
+  if (req->hasHeader("If-None-Match") && req->getHeader("If-None-Match")->value() == a.etag) {
+    AsyncWebServerResponse *r = req->beginResponse(304);
+    r->addHeader("ETag", a.etag);
+    req->send(r);
+    return;
   }
+  bool immutable = a.version[0] && req->hasParam("v") && req->getParam("v")->value() == a.version;
+  AsyncWebServerResponse *r = req->beginResponse_P(200, a.contentType, a.gz, a.len);
+  r->addHeader("Content-Encoding", "gzip");  // Tous les navigateurs acceptent gzip
+  r->addHeader("ETag", a.etag);
+  r->addHeader("Cache-Control", immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  req->send(r);
 }
+#endif
 
-static void appendCsv(const Sample3 &s) {
-  File f = SPIFFS.open(CSV_DATA, FILE_APPEND);
-  if (!f) return;
-
-  // Formater le timestamp en date/heure lisible
-  time_t t = s.t + timeOffsetSeconds;
-  struct tm* timeinfo = localtime(&t);
-  char timeStr[20];
-  strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);
-
-  f.printf("%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
-    timeStr,
-    s.b1Temp, s.b1Hum, s.b1O2,
-    s.b2Temp, s.b2Hum,
-    s.b3Temp, s.b3Hum
-  );
-  f.close();
+static bool requireAuth(AsyncWebServerRequest *request) {
+  if (!request->authenticate(auth_user, auth_pass)) {
+    request->requestAuthentication();
+    return false;
+  }
+  return true;
 }
 
 // ---------- Public API ----------
@@ -225,27 +271,39 @@ static void setTimeFromClient(time_t clientTime) {
   
   // Récupérer l'heure actuelle de l'ESP (avant la synchro)
   time_t espTimeNow = time(nullptr);
+  long drift = (long)(clientTime - espTimeNow);
   
-  // Configurer timezone France (CET/CEST)
-  setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
-  tzset();
-  
-  // Mettre à jour l'heure de l'ESP une seule fois
-  struct timeval tv;
-  tv.tv_sec = clientTime;
-  tv.tv_usec = 0;
-  settimeofday(&tv, nullptr);
-  
-  // Calculer l'offset à appliquer aux anciennes données
-  timeOffsetSeconds = clientTime - espTimeNow;
+  // Nouveau segment d'horloge (horloge avancée si elle retardait) : les échantillons déjà
+  // enregistrés gardent leur temps brut, corrigé à la lecture (clock_store.h)
+  bool changed = clockSync(clientTime);
+  if (changed) latestRebuild();  // Le temps exporté change
   
   timeSynced = true;
   
   Serial.print("[TIME] Synchro CLIENT: ");
   Serial.println(ctime(&clientTime));
-  Serial.print("[TIME] Offset appliqué: ");
-  Serial.print(timeOffsetSeconds);
-  Serial.println(" secondes");
+  Serial.print("[TIME] Ecart: ");
+  Serial.print(drift);
+  Serial.println(changed ? " secondes, nouveau segment" : " secondes, negligeable");
+}
+
+// ---------- Consommateurs du pipeline ----------
+static void persistSample(const Sample3 &s) {
+  // Tâche flash (cœur 0) ; le CSV part par pages entières (voir csv_log.h)
+  if (!storagePersist(s)) Serial.println("[CSV] Erreur ecriture");
+}
+
+static void publishSample(const Sample3 &s) {
+  // Tâche réseau : RAM + /api/latest + SSE
+  historyPush(s);
+
+  // id = séquence + 1 : continue d'un boot à l'autre (le ring est rechargé depuis tout le CSV)
+  latestRebuild();
+  LatestSnapshot snap;
+  latestSnapshot(snap);
+  events.send(snap.json, "sample", historySeq());
+
+  Serial.println("[WEB] Sample pushed");
 }
 
 void webInit() {
@@ -253,10 +311,16 @@ void webInit() {
     Serial.println("SPIFFS mount FAILED");
     return;
   }
-  ensureCsvHeader();
+  storageBegin();
+  bootId = esp_random();
+  if (!latestLock) latestLock = xSemaphoreCreateMutex();
   
   // Charger les données existantes du CSV
   loadHistoryFromCSV();
+  latestRebuild();
+
+  // Flash et diffusion en tâches de fond (historyPush n'a plus qu'un écrivain : la tâche réseau)
+  pipelineBegin(persistSample, publishSample);
 
   // Configurer WiFi AP
   WiFi.mode(WIFI_AP);
@@ -275,20 +339,87 @@ void webInit() {
   syncNTP();
 
   // Page HTML
+#if WEB_ASSETS_GZ
+  for (const WebAsset &a : WEB_ASSETS) {
+    server.on(a.path, HTTP_GET, [&a](AsyncWebServerRequest *request) {
+      // if (!requireAuth(request)) return;  // Auth disabled for testing
+      sendAsset(request, a);
+    });
+  }
+#else
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
     // if (!requireAuth(request)) return;  // Auth disabled for testing
     request->send_P(200, "text/html", INDEX_HTML);
   });
+#endif
 
   // API latest/history
   server.on("/api/latest", HTTP_GET, [](AsyncWebServerRequest *req) {
     // if (!requireAuth(req)) return;  // Auth disabled
-    req->send(200, "application/json", latestJson());
+    LatestSnapshot snap;
+    latestSnapshot(snap);
+    if (req->hasHeader("If-None-Match") && req->getHeader("If-None-Match")->value() == snap.etag) {
+      AsyncWebServerResponse *r = req->beginResponse(304);
+      r->addHeader("ETag", snap.etag);
+      req->send(r);
+      return;
+    }
+    // Corps copié dans la réponse : le snapshot peut être reconstruit pendant l'envoi
+    AsyncWebServerResponse *r = req->beginResponse(200, "application/json", String(snap.json));
+    r->addHeader("ETag", snap.etag);
+    r->addHeader("Cache-Control", "no-cache");
+    req->send(r);
   });
 
   server.on("/api/history", HTTP_GET, [](AsyncWebServerRequest *req) {
     // if (!requireAuth(req)) return;  // Auth disabled
-    req->send(200, "application/json", historyJson());
+    sendHistory(req);
+  });
+
+  server.on("/api/query", HTTP_GET, [](AsyncWebServerRequest *req) {
+    // if (!requireAuth(req)) return;  // Auth disabled
+    sendQuery(req);
+  });
+
+  // Identité de l'appareil (clé du cache local de l'IHM) et temps exporté du dernier échantillon
+  // epochs : segments d'horloge [rawFrom, offset, rawSync, syncOffset] ; le cache du navigateur
+  // les compare à ceux de sa visite précédente pour retrouver les points redatés
+  server.on("/api/info", HTTP_GET, [](AsyncWebServerRequest *req) {
+    Sample3 s;
+    uint32_t lastT = historyLatest(s) ? clockReal(s.t) : 0;
+    EpochTable epochs;
+    clockEpochs(epochs);
+    char j[64 + EPOCH_MAX * 48];
+    int n = snprintf(j, sizeof(j), "{\"device\":\"%012llx\",\"lastT\":%lu,\"epochs\":[",
+                     (unsigned long long)ESP.getEfuseMac(), (unsigned long)lastT);
+    for (uint8_t i = 0; i < epochs.count; i++) {
+      const EpochSegment &g = epochs.seg[i];
+      n += snprintf(j + n, sizeof(j) - n, "%s[%lu,%ld,%lu,%ld]", i ? "," : "", (unsigned long)g.rawFrom,
+                    (long)g.offset, (unsigned long)g.rawSync, (long)g.syncOffset);
+    }
+    snprintf(j + n, sizeof(j) - n, "]}");
+    req->send(200, "application/json", j);
+  });
+
+  // Files du pipeline : profondeur, pertes, pires durées
+  server.on("/api/pipeline", HTTP_GET, [](AsyncWebServerRequest *req) {
+    PipelineStats st;
+    pipelineStats(st);
+    char j[320];
+    int n = snprintf(j, sizeof(j), "{\"samples\":%lu,\"persistMaxUs\":%lu,\"publishMaxUs\":%lu",
+                     (unsigned long)st.samples, (unsigned long)st.persistMaxUs, (unsigned long)st.publishMaxUs);
+    const PipelineQueueStats *qs[2] = {&st.storage, &st.web};
+    const char *names[2] = {"storage", "web"};
+    for (int i = 0; i < 2; i++) {
+      n += snprintf(j + n, sizeof(j) - n,
+                    ",\"%s\":{\"depth\":%lu,\"highWater\":%lu,\"capacity\":%lu,\"pushed\":%lu,\"drops\":%lu}",
+                    names[i], (unsigned long)qs[i]->depth, (unsigned long)qs[i]->highWater,
+                    (unsigned long)qs[i]->capacity, (unsigned long)qs[i]->pushed, (unsigned long)qs[i]->drops);
+    }
+    snprintf(j + n, sizeof(j) - n, "}");
+    AsyncWebServerResponse *r = req->beginResponse(200, "application/json", j);
+    r->addHeader("Cache-Control", "no-store");
+    req->send(r);
   });
 
   // Endpoint pour mettre à jour l'heure depuis le client
@@ -332,40 +463,52 @@ void webInit() {
     }
   });
 
-  // CSV download (généré depuis l'historique RAM avec bon format)
+  // CSV download : journal flash complet en flux, ?from=&to= (epoch) optionnels
   server.on("/csv/data", HTTP_GET, [](AsyncWebServerRequest *request) {
     // if (!requireAuth(request)) return;  // Auth disabled
-    
-    // Générer le CSV à la volée
-    String csvContent = "date_time,temperature_bac1,humidity_bac1,oxygen_bac1,temperature_bac2,humidity_bac2,temperature_bac3,humidity_bac3\n";
-    
-    for (size_t i = 0; i < histCount; i++) {
-      size_t idx = (histHead + HISTORY_SIZE - histCount + i) % HISTORY_SIZE;
-      const Sample3 &s = historyBuf[idx];
-      
-      // Formater la date/heure
-      time_t t = s.t + timeOffsetSeconds;
-      struct tm* timeinfo = localtime(&t);
-      char timeStr[20];
-      strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);
-      
-      // Ajouter la ligne
-      char line[256];
-      snprintf(line, sizeof(line), "%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
-        timeStr,
-        s.b1Temp, s.b1Hum, s.b1O2,
-        s.b2Temp, s.b2Hum,
-        s.b3Temp, s.b3Hum
-      );
-      csvContent += line;
+    uint32_t from = request->hasParam("from") ? (uint32_t)request->getParam("from")->value().toInt() : 0;
+    uint32_t to = request->hasParam("to") ? (uint32_t)request->getParam("to")->value().toInt() : 0xFFFFFFFF;
+
+    CsvExport *raw = new (std::nothrow) CsvExport;
+    if (!raw) {
+      request->send(503, "text/plain", "out of memory");
+      return;
     }
-    
-    // Envoyer le CSV
-    AsyncWebServerResponse *response = request->beginResponse(200, "text/csv", csvContent);
+    EpochTable epochs;
+    clockEpochs(epochs);
+    csvExportBegin(*raw, epochs, from, to);
+    std::shared_ptr<CsvExport> exp(raw);  // Fichier fermé avec la réponse
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/csv", [exp](uint8_t *buf, size_t maxLen, size_t) {
+      size_t n = csvExportFill(*exp, buf, maxLen);
+      return n == CSV_SCAN_AGAIN ? (size_t)RESPONSE_TRY_AGAIN : n;
+    });
     response->addHeader("Content-Disposition", "attachment; filename=data.csv");
     request->send(response);
   });
 
+  // Reconnexion EventSource : rejouer les échantillons manqués (Last-Event-ID = séquence + 1)
+  events.onConnect([](AsyncEventSourceClient *client) {
+    uint32_t last = client->lastId();
+    if (last == 0) return;  // Première connexion : l'historique vient de /api/history
+    uint32_t oldest, end;
+    historyRange(oldest, end);
+    if (last == end) return;
+    if (last > end || last < oldest || end - last > SSE_REPLAY_MAX) {
+      // Trou trop grand (ou journal différent) : le client recharge via /api/history?since=
+      client->send("{}", "resync", end);
+      return;
+    }
+    EpochTable epochs;
+    clockEpochs(epochs);
+    historyForEachFrom(last, [&](uint32_t seq, const Sample3 &s) {
+      char j[JSON_SAMPLE_MAX];
+      size_t n = jsonSample(j, sizeof(j) - 1, s, epochOffset(epochs, (uint32_t)s.t));
+      j[n] = '\0';
+      client->send(j, "sample", seq + 1);
+      return true;
+    });
+  });
   server.addHandler(&events);
   server.begin();
 
@@ -373,6 +516,10 @@ void webInit() {
 }
 
 void webStop() {
+  // Dernier lot CSV en flash avant le deep sleep qui suit, si la tâche flash est bien arrêtée :
+  // sinon elle écrit encore et un second écrivain casserait le contrat de csv_log.h
+  if (pipelineStop()) storageFlush();
+  else Serial.println("[WEB] Tache flash active, dernier lot CSV non ecrit");
   server.end();
   WiFi.softAPdisconnect(true);  // Arrêter le WiFi AP
   WiFi.mode(WIFI_OFF);
@@ -380,14 +527,8 @@ void webStop() {
 }
 
 void webPushSample(const Sample3 &s) {
-  // Stocker en RAM + écrire CSV + SSE
-  pushHistory(s);
-  appendCsv(s);
-
-  String j = latestJson();
-  events.send(j.c_str(), "sample", millis());
-  
-  Serial.println("[WEB] Sample pushed");
+  // Flash (CSV, agrégats, archive) et RAM + SSE faits par les tâches du pipeline
+  if (!pipelinePush(s)) Serial.println("[WEB] File pleine, echantillon perdu");
 }
 
 void webLoop() {
@@ -0,0 +1,163 @@
+// Benchmark natif de compost_dump sur des images SPIFFS synthétiques pluriannuelles.
+//
+//   g++ -O2 -std=c++17 -Iinclude -Itools/compost_dump tools/bench_compost_dump.cpp
+//       tools/compost_dump/spiffs_image.cpp tools/compost_dump/log_export.cpp
+//       src/csv_record.cpp src/ts_codec.cpp src/rollup.cpp src/epoch_table.cpp src/date_format.cpp
+//       -o bench_compost_dump
+//   ./bench_compost_dump
+//
+// Chaque image contient /data.csv, /archive.bin, /archive.open, les agrégats horaires/journaliers
+// et la table d'horloge (/epochs.bin, synchro mensuelle) d'une unité échantillonnée toutes les
+// heures pendant 1, 4 puis 8 ans
+// (l'index de page SPIFFS sur 16 bits limite une image à 16 MB).
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "archive_store.h"
+#include "csv_record.h"
+#include "log_export.h"
+#include "rollup_store.h"
+#include "spiffs_image.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double since(Clock::time_point t0) {
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static std::vector<uint8_t> makeImage(double years, size_t &samples) {
+  samples = (size_t)(years * 365 * 24);
+  std::string csv = std::string(CSV_HEADER) + "\n", sealed, journal, rollups[ROLLUP_TIER_COUNT];
+  uint8_t block[TS_BLOCK_SIZE];
+  TsBlockEncoder enc;
+  enc.begin(block);
+  RollupBucket open[ROLLUP_TIER_COUNT];
+  for (int i = 0; i < ROLLUP_TIER_COUNT; i++) rollupReset(open[i], 0);
+
+  srand(7);
+  uint32_t t = 1600000000;
+  char line[CSV_RECORD_MAX];
+  uint8_t rec[ROLLUP_RECORD_SIZE];
+  for (size_t i = 0; i < samples; i++) {
+    t += 3600 + rand() % 9 - 4;
+    Sample3 s;
+    s.t = t;
+    for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+      double v = (c == 2 ? 20.0 : 45.0) + 10.0 * sin(i / 200.0 + c) + (rand() % 11 - 5) / 10.0;
+      sample3Set(s, c, roundf((float)v * 10.0f) / 10.0f);
+    }
+    size_t len = csvFormatRecord(s, line, sizeof(line));
+    csv.append(line, len);
+
+    if (!enc.append(s)) {
+      enc.seal();
+      sealed.append((const char *)block, TS_BLOCK_SIZE);
+      journal.clear();
+      enc.begin(block);
+      enc.append(s);
+    }
+    journal.append(line, len);
+
+    for (int r = 0; r < ROLLUP_TIER_COUNT; r++) {
+      uint32_t start = rollupBucketStart((RollupTier)r, t);
+      if (open[r].samples && open[r].start != start) {
+        rollupEncode(open[r], rec);
+        rollups[r].append((const char *)rec, sizeof(rec));
+        rollupReset(open[r], start);
+      }
+      open[r].start = start;
+      rollupAdd(open[r], s);
+    }
+  }
+
+  // Horloge en avance d'environ 20 s par mois, resynchronisée chaque mois (sans recul)
+  EpochTable epochs;
+  epochInit(epochs);
+  for (uint32_t raw = 1600000000; raw < t; raw += 30 * 86400) {
+    epochSync(epochs, raw, raw - (raw - 1600000000) / 130000);
+  }
+  uint8_t epochBuf[EPOCH_RECORD_MAX];
+  std::string epochFile((const char *)epochBuf, epochEncode(epochs, epochBuf));
+
+  // Rotation des agrégats comme sur le firmware : seules les deux dernières générations restent
+  std::string oldGen[ROLLUP_TIER_COUNT];
+  for (int r = 0; r < ROLLUP_TIER_COUNT; r++) {
+    size_t n = rollups[r].size() / ROLLUP_RECORD_SIZE;
+    if (n == 0) continue;
+    size_t cur = (n - 1) % ROLLUP_GEN_RECORDS[r] + 1;
+    size_t old = n - cur < ROLLUP_GEN_RECORDS[r] ? n - cur : ROLLUP_GEN_RECORDS[r];
+    oldGen[r] = rollups[r].substr((n - cur - old) * ROLLUP_RECORD_SIZE, old * ROLLUP_RECORD_SIZE);
+    rollups[r] = rollups[r].substr((n - cur) * ROLLUP_RECORD_SIZE);
+  }
+
+  size_t total = csv.size() + sealed.size() + 64 * 1024;
+  for (int r = 0; r < ROLLUP_TIER_COUNT; r++) total += oldGen[r].size() + rollups[r].size();
+  SpiffsImageBuilder builder(total + total / 8);  // Tables de pages + index + en-têtes
+  bool ok = builder.addFile(CSV_LOG_FILE, csv) && builder.addFile(ARCHIVE_FILE, sealed) &&
+            builder.addFile(ARCHIVE_OPEN_FILE, journal) && builder.addFile(EPOCH_FILE, epochFile);
+  for (int r = 0; ok && r < ROLLUP_TIER_COUNT; r++) {
+    ok = builder.addFile(ROLLUP_FILES[r], rollups[r]) &&
+         (oldGen[r].empty() || builder.addFile(ROLLUP_OLD_FILES[r], oldGen[r]));
+  }
+  if (!ok) fprintf(stderr, "image pleine (%.0f ans)\n", years);
+  return builder.image();
+}
+
+static void run(const char *label, const SpiffsImage &fs, LogSource source, const char *format,
+                size_t imageBytes, FILE *sink) {
+  ExportOptions opt;
+  opt.source = source;
+  SampleWriter *w;
+  std::string f = format;
+  if (f == "csv") w = new CsvWriter(sink, false);
+  else if (f == "json") w = new JsonWriter(sink, false);
+  else w = new StatsWriter(sink);
+
+  DecodeCounters c;
+  std::string err;
+  auto t0 = Clock::now();
+  w->begin(source == SOURCE_HOUR || source == SOURCE_DAY);
+  bool ok = exportImage(fs, "bench", opt, *w, c, err);
+  w->end();
+  delete w;
+  double s = since(t0);
+  size_t n = c.ok + c.legacy;
+  printf("  %-8s -> %-5s : %8zu points en %7.1f ms  (%6.2f M pts/s, image %6.0f MB/s)%s\n", label, format,
+         n, s * 1e3, n / s / 1e6, imageBytes / s / 1e6, ok && c.bad == 0 ? "" : "  ERREUR");
+}
+
+int main() {
+  FILE *sink = fopen("/dev/null", "wb");
+  if (!sink) return 1;
+
+  for (double years : {1.0, 4.0, 8.0}) {
+    size_t samples;
+    std::vector<uint8_t> img = makeImage(years, samples);
+
+    auto t0 = Clock::now();
+    SpiffsImage fs;
+    if (!fs.open(img.data(), img.size())) {
+      fprintf(stderr, "%s\n", fs.error.c_str());
+      return 1;
+    }
+    double openS = since(t0);
+
+    printf("%.0f an(s), %zu echantillons, image %.1f MB, montage %.2f ms\n", years, samples,
+           img.size() / 1e6, openS * 1e3);
+    for (const SpiffsFile &f : fs.files()) printf("  %-16s %9u octets\n", f.name.c_str(), f.size);
+    run("csv", fs, SOURCE_CSV, "csv", img.size(), sink);
+    run("csv", fs, SOURCE_CSV, "stats", img.size(), sink);
+    run("archive", fs, SOURCE_ARCHIVE, "csv", img.size(), sink);
+    run("archive", fs, SOURCE_ARCHIVE, "json", img.size(), sink);
+    run("archive", fs, SOURCE_ARCHIVE, "stats", img.size(), sink);
+    run("hour", fs, SOURCE_HOUR, "csv", img.size(), sink);
+    run("day", fs, SOURCE_DAY, "json", img.size(), sink);
+  }
+  fclose(sink);
+  return 0;
+}
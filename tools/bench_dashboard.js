@@ -0,0 +1,273 @@
+// Benchmark sans navigateur de l'IHM (script de INDEX_HTML, include/web_page.h).
+//
+//   node tools/bench_dashboard.js            # historiques de 300, 3 000 et 30 000 points
+//   node tools/bench_dashboard.js 1000 5000  # tailles au choix
+//
+// Le script de la page et celui du worker de données tournent tels quels dans deux contextes
+// Node (vm), face à un serveur simulé : /api/settime, /api/info, /api/history (format binaire
+// de history_stream.h, ?since= respecté) et /events (SSE piloté par le benchmark).
+// Le DOM et les canvas sont des bouchons : les appels de dessin sont comptés, pas rastérisés.
+// Le worker est exécuté dans le même thread (messages asynchrones, clonés comme par le navigateur),
+// ce qui permet de séparer le temps du thread principal (ce qui fige la page) du temps total.
+// Pas d'IndexedDB : première visite, sans cache.
+//
+// Mesures, vue Bac puis vue Comparaison (trois canvas) :
+//   - chargement initial : exécution du script -> historique chargé et tracé ;
+//   - événement SSE "sample" : réception -> nouvelle frame tracée ;
+//   - survol : mousemove -> image suivante (requestAnimationFrame) redessinée.
+// Aucune dépendance ; Node >= 17 (structuredClone).
+
+'use strict';
+
+const fs = require('fs');
+const path = require('path');
+const vm = require('vm');
+const {performance} = require('perf_hooks');
+
+// ---------- Page ----------
+const SOURCE = path.join(__dirname, '..', 'include', 'web_page.h');
+const page = fs.readFileSync(SOURCE, 'utf8').match(/R"HTML\(([\s\S]*)\)HTML"/)[1];
+const MAIN_JS = page.match(/<script>\n([\s\S]*?)<\/script>/)[1];
+const WORKER_JS = (page.match(/<script id="dataWorker"[^>]*>([\s\S]*?)<\/script>/) || [])[1] || '';
+
+const T0 = 1700000000;
+const STEP = 60;
+const SSE_SAMPLES = 50;
+const HOVERS = 200;
+
+// ---------- Données synthétiques ----------
+// Cycles lents + bruit + pics isolés, O2 parfois absent (même esprit que bench_downsample)
+function channelValue(i, c){
+  const base = (c % 2 === 0) ? 45 : 60;
+  const noise = ((i * 7919 + c * 104729) % 201 - 100) / 100;
+  let v = base + 10 * Math.sin(i / (400 + 37 * c)) + 2 * Math.sin(i / 22.9) + noise;
+  if((i * 31 + c) % 997 === 0) v += 15;
+  if(c === 2 && i % 50 === 0) return NaN;
+  return v;
+}
+
+// Réponse binaire de /api/history pour les échantillons d'indice >= first
+function historyBin(n, first){
+  const m = Math.max(0, n - first);
+  const buf = new ArrayBuffer(12 + 4 * m + 2 * 7 * m);
+  const dv = new DataView(buf);
+  dv.setUint16(0, 0x4843, true);
+  dv.setUint8(2, 1);
+  dv.setUint16(4, m, true);
+  dv.setUint16(6, 7, true);
+  dv.setUint32(8, T0 + STEP * first, true);
+  let off = 12;
+  for(let i = 0; i < m; i++, off += 4) dv.setUint32(off, i ? STEP : 0, true);
+  for(let c = 0; c < 7; c++){
+    for(let i = first; i < n; i++, off += 2){
+      const v = channelValue(i, c);
+      dv.setInt16(off, v === v ? Math.round(v * 100) : -32768, true);
+    }
+  }
+  return buf;
+}
+
+function sampleJson(i){
+  const v = (c)=>{ const x = channelValue(i, c); return x === x ? Number(x.toFixed(2)) : null; };
+  return JSON.stringify({t: T0 + STEP * i, b1: {tempC: v(0), humPct: v(1), o2Pct: v(2)},
+                         b2: {tempC: v(3), humPct: v(4)}, b3: {tempC: v(5), humPct: v(6)}});
+}
+
+// ---------- Environnement simulé ----------
+function makeEnv(n){
+  const env = {n, drawOps: 0, domOps: 0, mainMs: 0, frames: 0, windows: 0, rafs: [], listeners: {}, es: null, latest: n};
+  const els = {};
+
+  // Temps passé dans un rappel du thread principal (le worker est compté à part)
+  const onMain = (fn)=> function(...a){
+    const t = performance.now();
+    try{ return fn.apply(this, a); } finally{ env.mainMs += performance.now() - t; }
+  };
+
+  function context2d(){
+    const ctx = {measureText: (s)=>({width: 6 * String(s).length})};
+    return new Proxy(ctx, {
+      get: (o, k)=> (k in o) ? o[k] : ()=>{ env.drawOps++; },
+      set: (o, k, v)=>{ o[k] = v; return true; }
+    });
+  }
+  // Élément minimal : arbre (appendChild/insertBefore), écritures de texte et déplacements comptés
+  function element(id){
+    let text = '', html = '';
+    const e = {
+      id, value: 'raw', className: '', style: {}, width: 0, height: 0, scrollTop: 0,
+      children: [], parentNode: null,
+      classList: {toggle(){}, add(){}, remove(){}},
+      get textContent(){ return text; },
+      set textContent(v){ text = String(v); env.domOps++; },
+      get innerHTML(){ return html; },
+      set innerHTML(v){ html = String(v); env.domOps++; },
+      get nextSibling(){
+        const c = e.parentNode ? e.parentNode.children : [];
+        return c[c.indexOf(e) + 1] || null;
+      },
+      insertBefore(child, ref){
+        if(child.parentNode) child.parentNode.children.splice(child.parentNode.children.indexOf(child), 1);
+        const k = ref ? e.children.indexOf(ref) : -1;
+        e.children.splice(k < 0 ? e.children.length : k, 0, child);
+        child.parentNode = e;
+        env.domOps++;
+        return child;
+      },
+      appendChild(child){ return e.insertBefore(child, null); },
+      addEventListener(type, fn){ (env.listeners[id + ':' + type] ||= []).push(onMain(fn)); },
+      getBoundingClientRect(){ return {left: 0, top: 0, width: 800, height: 300}; },
+      getContext(){ return context2d(); }
+    };
+    return e;
+  }
+  els.dataWorker = {textContent: WORKER_JS};
+  env.els = els;
+
+  async function fetchMock(url){
+    url = url.replace(/^https?:\/\/[^/]+/, '');
+    if(url.startsWith('/api/settime')) return {ok: true, status: 200, json: async()=>({ok: true})};
+    if(url.startsWith('/api/info')) return {ok: true, status: 200, json: async()=>({device: 'bench', lastT: T0 + STEP * (env.latest - 1)})};
+    if(url.startsWith('/api/history')){
+      const since = +((url.match(/since=(\d+)/) || [])[1] || 0);
+      const first = since ? Math.max(0, Math.floor((since - T0) / STEP) + 1) : 0;
+      return {ok: true, status: 200, arrayBuffer: async()=>historyBin(env.latest, Math.min(first, env.latest))};
+    }
+    return {ok: false, status: 404};
+  }
+
+  const base = {console: {log(){}, error: (...a)=>process.stderr.write(a.join(' ') + '\n')},
+                fetch: fetchMock, setTimeout: (f)=>setImmediate(f), setInterval: ()=>0, clearTimeout(){}};
+
+  const blobs = new Map();
+  class BenchWorker{
+    constructor(url){
+      const self = this;
+      this.ctx = vm.createContext(Object.assign({}, base, {
+        postMessage: (m)=>{
+          const d = structuredClone(m);
+          if(d.type === 'frame') env.frames++;
+          if(d.type === 'rows') env.windows++;
+          setImmediate(()=>{ if(self.onmessage) onMain(self.onmessage)({data: d}); });
+        }
+      }));
+      this.ctx.self = this.ctx;
+      vm.runInContext(blobs.get(url), this.ctx);
+    }
+    postMessage(m){
+      const d = structuredClone(m);
+      setImmediate(()=>this.ctx.onmessage({data: d}));
+    }
+  }
+
+  class BenchEventSource{
+    constructor(){ env.es = this; this.handlers = {}; }
+    addEventListener(type, fn){ this.handlers[type] = onMain(fn); }
+  }
+
+  env.ctx = vm.createContext(Object.assign({}, base, {
+    Worker: BenchWorker,
+    Blob: class{ constructor(parts){ this.text = parts.join(''); } },
+    URL: {createObjectURL: (b)=>{ const u = 'blob:' + blobs.size; blobs.set(u, b.text); return u; }},
+    location: {origin: 'http://192.168.10.1'},
+    document: {getElementById: (id)=> els[id] || (els[id] = element(id)), createElement: ()=>element('offscreen')},
+    window: {devicePixelRatio: 1, addEventListener(){}},
+    requestAnimationFrame: (f)=>{ env.rafs.push(onMain(f)); return env.rafs.length; },
+    EventSource: BenchEventSource
+  }));
+  return env;
+}
+
+// ---------- Mesures ----------
+// {wall, main, ops, dom} : par opération (ms, appels canvas, écritures DOM)
+const tick = ()=> new Promise((r)=>setImmediate(r));
+async function until(cond, what){
+  for(let i = 0; i < 1e6; i++){
+    if(cond()) return;
+    await tick();
+  }
+  throw new Error('délai dépassé : ' + what);
+}
+
+function flushFrame(env){
+  const callbacks = env.rafs.splice(0);
+  for(const f of callbacks) f(performance.now());
+}
+
+async function measure(env, count, step){
+  const m0 = env.mainMs, o0 = env.drawOps, d0 = env.domOps;
+  const t = performance.now();
+  for(let k = 0; k < count; k++) await step(k);
+  return {wall: (performance.now() - t) / count, main: (env.mainMs - m0) / count,
+          ops: (env.drawOps - o0) / count, dom: (env.domOps - d0) / count};
+}
+
+// Échantillon SSE -> frame reçue et tracée
+function sseStep(env){
+  return async()=>{
+    const frames = env.frames;
+    env.es.handlers.sample({data: sampleJson(env.latest++)});
+    await until(()=>env.frames > frames, 'frame après SSE');
+    await tick();
+  };
+}
+
+function hoverStep(env, canvasId){
+  const move = env.listeners[canvasId + ':mousemove'][0];
+  return async(k)=>{
+    move({clientX: 20 + (k * 37) % 760});
+    flushFrame(env);
+  };
+}
+
+// Défilement de la table par bonds de 7 lignes -> fenêtre reçue du worker et affichée
+function scrollStep(env){
+  const box = env.els.tableScroll, onScroll = env.listeners['tableScroll:scroll'][0];
+  return async(k)=>{
+    const windows = env.windows;
+    box.scrollTop = ((k + 1) * 7 * 34) % (34 * Math.max(1, env.n - 30));
+    onScroll();
+    flushFrame(env);
+    await until(()=>env.windows > windows, 'fenêtre de table');
+    await tick();
+  };
+}
+
+async function run(n){
+  const env = makeEnv(n);
+  const t = performance.now();
+  vm.runInContext(MAIN_JS, env.ctx);
+  env.mainMs += performance.now() - t;
+  await until(()=>/chargé|cache/.test(env.els.hint.textContent) && env.frames > 0, 'chargement initial');
+  await tick();
+  const load = {wall: performance.now() - t, main: env.mainMs, ops: env.drawOps, dom: env.domOps};
+  if(env.els.err.textContent) throw new Error(env.els.err.textContent + ' ' + env.els.hint.textContent);
+
+  const r = {hint: env.els.hint.textContent, 'chargement initial': load};
+  r['SSE, vue Bac'] = await measure(env, SSE_SAMPLES, sseStep(env));
+  r['survol, vue Bac'] = await measure(env, HOVERS, hoverStep(env, 'plotBac'));
+  r['défilement table'] = await measure(env, SSE_SAMPLES, scrollStep(env));
+  env.listeners['viewCmpBtn:click'][0]();
+  await tick();
+  r['SSE, comparaison'] = await measure(env, SSE_SAMPLES, sseStep(env));
+  r['survol, comparaison'] = await measure(env, HOVERS, hoverStep(env, 'plotTemp'));
+  return r;
+}
+
+function num(v, w){ return v.toFixed(v < 10 ? 3 : 1).padStart(w); }
+
+(async()=>{
+  const sizes = process.argv.slice(2).map(Number).filter((x)=>x > 0);
+  if(!sizes.length) sizes.push(300, 3000, 30000);
+  await run(sizes[0]);  // Chauffe du JIT, non affichée
+  console.log('Par opération : temps total et du thread principal (ms), appels canvas, écritures DOM');
+  for(const n of sizes){
+    const r = await run(n);
+    console.log(`\n${n} points (${r.hint})`);
+    console.log('                       total   principal    canvas       DOM');
+    for(const [name, m] of Object.entries(r)){
+      if(name === 'hint') continue;
+      console.log(`  ${name.padEnd(20)}${num(m.wall, 7)} ${num(m.main, 10)} ${String(Math.round(m.ops)).padStart(9)} ${String(Math.round(m.dom)).padStart(9)}`);
+    }
+  }
+})().catch((e)=>{ console.error('bench_dashboard:', e.message); process.exit(1); });
@@ -0,0 +1,96 @@
+// Benchmark natif du formatage des dates de l'export CSV (/csv/data).
+//
+//   g++ -O2 -std=c++17 -Iinclude tools/bench_date_format.cpp src/date_format.cpp
+//       -o bench_date_format
+//   ./bench_date_format
+//
+// Compare, pour une saison d'échantillons (une mesure par minute, mars à novembre, heure
+// d'Europe centrale avec ses deux changements d'heure) :
+//   strftime : localtime_r + strftime par ligne (ancien export)
+//   cache    : fmtDateTime (préfixe du jour en cache, heure du jour en arithmétique)
+// puis vérifie la sortie caractère par caractère, y compris sur des instants en désordre.
+
+#include "date_format.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+static const char *TZ_BENCH = "CET-1CEST,M3.5.0,M10.5.0/3";
+
+// ---------- Ancienne version ----------
+static size_t legacyDate(char *out, time_t t) {
+  struct tm lt;
+  localtime_r(&t, &lt);
+  return strftime(out, 32, "%Y-%m-%d %H:%M:%S", &lt);
+}
+
+// ---------- Données ----------
+static std::vector<time_t> makeSeason() {
+  std::vector<time_t> ts;
+  time_t t0 = 1709251200;                  // 2024-03-01 00:00 UTC
+  time_t t1 = t0 + 275L * 86400;           // Fin novembre
+  for (time_t t = t0; t < t1; t += 60) ts.push_back(t);
+  return ts;
+}
+
+static std::vector<time_t> makeShuffled(size_t n) {
+  std::vector<time_t> ts;
+  srand(42);
+  for (size_t i = 0; i < n; i++) {
+    // 2000..2037, avec des rafales proches des changements d'heure (dernier dimanche de mars/octobre)
+    time_t t = 946684800 + (time_t)(((uint64_t)rand() << 16 ^ (uint64_t)rand()) % (37ULL * 365 * 86400));
+    if (i % 4 == 0) t = 1711846800 + (rand() % 7200) - 3600;  // 2024-03-31 01:00 UTC ± 1 h
+    if (i % 4 == 1) t = 1729990800 + (rand() % 7200) - 3600;  // 2024-10-27 01:00 UTC ± 1 h
+    ts.push_back(t);
+  }
+  return ts;
+}
+
+static size_t compare(const std::vector<time_t> &ts) {
+  DateCache c;
+  size_t diff = 0;
+  for (time_t t : ts) {
+    char a[32], b[32];
+    size_t la = legacyDate(a, t);
+    size_t lb = (size_t)(fmtDateTime(c, b, t) - b);
+    if (la != lb || memcmp(a, b, la) != 0) {
+      if (diff < 5) printf("  diff %ld : %.*s / %.*s\n", (long)t, (int)la, a, (int)lb, b);
+      diff++;
+    }
+  }
+  return diff;
+}
+
+template <typename F>
+static void run(const char *name, size_t n, F f) {
+  size_t bytes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i++) bytes += f(i);
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+  printf("  %-9s : %7.1f ns/ligne  %8.0f lignes/ms  (%zu octets)\n", name, ns, 1e6 / ns, bytes);
+}
+
+int main() {
+  setenv("TZ", TZ_BENCH, 1);
+  tzset();
+
+  std::vector<time_t> season = makeSeason();
+  std::vector<time_t> shuffled = makeShuffled(200000);
+  size_t n = season.size();
+
+  printf("%zu lignes (saison), %zu sorties différentes de strftime\n", n, compare(season));
+  printf("%zu instants en désordre, %zu sorties différentes de strftime\n", shuffled.size(),
+         compare(shuffled));
+
+  char buf[32];
+  printf("Saison, ordre chronologique :\n");
+  run("strftime", n, [&](size_t i) { return legacyDate(buf, season[i]); });
+  DateCache c;
+  run("cache", n, [&](size_t i) { return (size_t)(fmtDateTime(c, buf, season[i]) - buf); });
+  return 0;
+}
@@ -0,0 +1,103 @@
+// Benchmark natif du sous-échantillonnage LTTB de /api/history?points=N.
+//
+//   g++ -O2 -std=c++17 -Iinclude tools/bench_downsample.cpp src/downsample.cpp -o bench_downsample
+//   ./bench_downsample
+//
+// Pour plusieurs tailles de source (ring RAM, un an d'agrégats horaires, maximum du format) :
+//   - temps par appel et par point source, mémoire temporaire ;
+//   - fidélité : amplitude conservée par les points retenus (pics inclus), comparée à une
+//     décimation naïve (1 point sur k).
+// Un ESP32 à 240 MHz est typiquement 20 à 50 fois plus lent qu'un PC sur ce calcul flottant.
+
+#include "downsample.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// ---------- Données ----------
+// Cycles lents (jour, compostage) + bruit + pics isolés (retournement, arrosage)
+static std::vector<DownsamplePoint> makeSeries(size_t n) {
+  std::vector<DownsamplePoint> out(n);
+  srand(11);
+  for (size_t i = 0; i < n; i++) {
+    DownsamplePoint &p = out[i];
+    p.t = 1700000000 + (uint32_t)i * 600;
+    for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+      float base = (c % 2 == 0) ? 45.0f : 60.0f;
+      float slow = 10.0f * sinf(i / (400.0f + 37 * c));
+      float daily = 2.0f * sinf(i / 22.9f);
+      float noise = (rand() % 201 - 100) / 100.0f;
+      p.v[c] = base + slow + daily + noise;
+    }
+    if (rand() % 500 == 0) p.v[rand() % SAMPLE3_CHANNELS] += (rand() % 2 ? 15.0f : -15.0f);
+    if (rand() % 50 == 0) p.v[2] = NAN;
+  }
+  return out;
+}
+
+static DownsampleSource sourceOf(const std::vector<DownsamplePoint> &pts) {
+  return [&pts](const DownsampleVisitor &cb) {
+    for (size_t k = 0; k < pts.size(); k++) {
+      if (!cb((uint32_t)k, pts[k])) return;
+    }
+  };
+}
+
+// Amplitude conservée : (max - min des points retenus) / (max - min de la source), pire canal, en %.
+// Un pic perdu se voit directement (la courbe réduite ne l'atteint plus).
+static float amplitudeKept(const std::vector<DownsamplePoint> &pts, const uint16_t *sel, size_t n) {
+  float worst = 100;
+  for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+    float lo = INFINITY, hi = -INFINITY, slo = INFINITY, shi = -INFINITY;
+    for (const DownsamplePoint &p : pts) {
+      if (isnan(p.v[c])) continue;
+      if (p.v[c] < lo) lo = p.v[c];
+      if (p.v[c] > hi) hi = p.v[c];
+    }
+    for (size_t j = 0; j < n; j++) {
+      float v = pts[sel[j]].v[c];
+      if (isnan(v)) continue;
+      if (v < slo) slo = v;
+      if (v > shi) shi = v;
+    }
+    if (!(hi > lo)) continue;
+    float kept = shi > slo ? 100 * (shi - slo) / (hi - lo) : 0;
+    if (kept < worst) worst = kept;
+  }
+  return worst;
+}
+
+static size_t strideSelect(size_t count, uint16_t points, uint16_t *sel) {
+  for (uint16_t j = 0; j < points; j++) sel[j] = (uint16_t)((uint64_t)j * (count - 1) / (points - 1));
+  return points;
+}
+
+int main() {
+  const size_t sizes[] = {600, 8760, 65535};
+  const uint16_t targets[] = {100, 500};
+
+  printf("%7s %6s %10s %9s %8s %12s %12s\n", "source", "points", "µs/appel", "ns/point", "tmp(o)",
+         "ampl LTTB %", "ampl pas %");
+  for (size_t count : sizes) {
+    std::vector<DownsamplePoint> pts = makeSeries(count);
+    DownsampleSource src = sourceOf(pts);
+    for (uint16_t points : targets) {
+      std::vector<uint16_t> sel(points), stride(points);
+      size_t n = 0;
+      int reps = count > 10000 ? 20 : 200;
+      auto t0 = std::chrono::steady_clock::now();
+      for (int r = 0; r < reps; r++) n = lttbSelect(src, (uint32_t)count, points, sel.data());
+      auto t1 = std::chrono::steady_clock::now();
+      double us = std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+
+      size_t ns = strideSelect(count, points, stride.data());
+      printf("%7zu %6u %10.1f %9.2f %8zu %12.1f %12.1f\n", count, points, us, us * 1000 / count,
+             (size_t)(points - 2) * (1 + SAMPLE3_CHANNELS) * sizeof(float), amplitudeKept(pts, sel.data(), n),
+             amplitudeKept(pts, stride.data(), ns));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Benchmark natif des sérialiseurs JSON de l'API (/api/latest, /api/history, SSE).
+//
+//   g++ -O2 -std=c++17 -Iinclude tools/bench_json.cpp src/json_writer.cpp src/fast_format.cpp
+//       src/rollup.cpp src/date_format.cpp -o bench_json
+//   ./bench_json
+//
+// Compare, pour les mêmes échantillons :
+//   string   : reproduction de l'ancien code (safeNum / String(v, 2) + concaténations)
+//   snprintf : un snprintf par élément
+//   writer   : JsonOut + descripteurs de champs (json_writer)
+// et compte les allocations tas par élément. L'ancien code est reproduit avec std::string,
+// dont le SSO sous-estime les allocations par rapport à String (Arduino).
+
+#include "json_writer.h"
+
+#include <chrono>
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+static size_t g_allocs = 0;
+
+void *operator new(size_t n) {
+  g_allocs++;
+  void *p = malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// ---------- Ancienne version (String) ----------
+static std::string stringFloat(float v) {  // String(v, 2) -> dtostrf
+  char buf[33];
+  snprintf(buf, sizeof(buf), "%.2f", v);
+  return std::string(buf);
+}
+
+static std::string safeNum(float v) {
+  if (!isfinite(v)) return "null";
+  std::string s = stringFloat(v);
+  return s;
+}
+
+static std::string legacyJson(const Sample3 &s) {
+  std::string j = "{";
+  j += "\"t\":" + std::to_string((long)s.t) + ",";
+  j += "\"b1\":{\"tempC\":" + safeNum(s.b1Temp) + ",\"humPct\":" + safeNum(s.b1Hum) + ",\"o2Pct\":" + safeNum(s.b1O2) + "},";
+  j += "\"b2\":{\"tempC\":" + safeNum(s.b2Temp) + ",\"humPct\":" + safeNum(s.b2Hum) + "},";
+  j += "\"b3\":{\"tempC\":" + safeNum(s.b3Temp) + ",\"humPct\":" + safeNum(s.b3Hum) + "}";
+  j += "}";
+  return j;
+}
+
+// ---------- snprintf ----------
+struct JsonNum {
+  char s[16];
+  explicit JsonNum(float v) {
+    if (isfinite(v)) snprintf(s, sizeof(s), "%.2f", v);
+    else snprintf(s, sizeof(s), "null");
+  }
+};
+
+static int snprintfJson(char *out, size_t cap, const Sample3 &s) {
+  return snprintf(out, cap,
+    "{\"t\":%ld,\"b1\":{\"tempC\":%s,\"humPct\":%s,\"o2Pct\":%s},"
+    "\"b2\":{\"tempC\":%s,\"humPct\":%s},\"b3\":{\"tempC\":%s,\"humPct\":%s}}",
+    (long)s.t, JsonNum(s.b1Temp).s, JsonNum(s.b1Hum).s, JsonNum(s.b1O2).s,
+    JsonNum(s.b2Temp).s, JsonNum(s.b2Hum).s, JsonNum(s.b3Temp).s, JsonNum(s.b3Hum).s);
+}
+
+// ---------- Données ----------
+static std::vector<Sample3> makeSamples(size_t n) {
+  std::vector<Sample3> out(n);
+  srand(7);
+  for (size_t i = 0; i < n; i++) {
+    Sample3 &s = out[i];
+    s.t = 1700000000 + (time_t)i * 600;
+    for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+      float base = (c % 2 == 0) ? 45.0f : 60.0f;
+      sample3Set(s, c, roundf((base + (rand() % 4001 - 2000) / 100.0f) * 100.0f) / 100.0f);
+    }
+    if (rand() % 50 == 0) s.b1O2 = NAN;
+  }
+  return out;
+}
+
+template <typename F>
+static void run(const char *name, size_t n, F f) {
+  size_t bytes = 0;
+  size_t allocs0 = g_allocs;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; i++) bytes += f(i);
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+  printf("  %-9s : %7.1f ns/élément  %5.2f alloc/élément  (%zu octets)\n", name, ns,
+         (double)(g_allocs - allocs0) / n, bytes);
+}
+
+int main() {
+  const size_t n = 200000;
+  std::vector<Sample3> samples = makeSamples(n);
+
+  // Même sortie que l'ancien code (à l'arrondi près des demi-centièmes)
+  size_t diff = 0;
+  for (size_t i = 0; i < n; i++) {
+    char buf[JSON_SAMPLE_MAX];
+    size_t len = jsonSample(buf, sizeof(buf), samples[i], 0);
+    if (legacyJson(samples[i]) != std::string(buf, len)) diff++;
+  }
+  printf("%zu échantillons, %zu sorties différentes de l'ancien code\n", n, diff);
+
+  printf("Échantillon (/api/history, SSE) :\n");
+  run("string", n, [&](size_t i) { return legacyJson(samples[i]).size(); });
+  run("snprintf", n, [&](size_t i) {
+    char buf[JSON_SAMPLE_MAX];
+    return (size_t)snprintfJson(buf, sizeof(buf), samples[i]);
+  });
+  run("writer", n, [&](size_t i) {
+    char buf[JSON_SAMPLE_MAX];
+    return jsonSample(buf, sizeof(buf), samples[i], 0);
+  });
+
+  printf("Créneau agrégé (/api/history?resolution=hour) :\n");
+  std::vector<RollupBucket> buckets(n / 24);
+  for (size_t i = 0; i < buckets.size(); i++) {
+    rollupReset(buckets[i], (uint32_t)samples[i * 24].t);
+    for (size_t k = 0; k < 24; k++) rollupAdd(buckets[i], samples[i * 24 + k]);
+  }
+  run("writer", buckets.size(), [&](size_t i) {
+    char buf[JSON_ROLLUP_MAX];
+    return jsonRollup(buf, sizeof(buf), buckets[i]);
+  });
+  return 0;
+}
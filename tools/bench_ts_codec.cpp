@@ -0,0 +1,91 @@
+// Benchmark natif du codec de blocs compressés (ts_codec).
+//
+//   g++ -O2 -std=c++17 -Iinclude tools/bench_ts_codec.cpp src/ts_codec.cpp -o bench_ts_codec
+//   ./bench_ts_codec [années]
+//
+// Génère une série horaire synthétique (courbes de compostage + bruit capteur au 0,1),
+// l'encode en blocs, la décode et vérifie l'aller-retour.
+
+#include "ts_codec.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static std::vector<Sample3> makeSeries(size_t n) {
+  std::vector<Sample3> out(n);
+  uint32_t t = 1700000000;
+  srand(42);
+  for (size_t i = 0; i < n; i++) {
+    t += 3600 + (rand() % 9) - 4;  // Réveil deep sleep : quelques secondes de gigue
+    double day = i / 24.0;
+    Sample3 &s = out[i];
+    s.t = t;
+    for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+      double base = (c == 2) ? 20.0 : (c % 2 == 0 ? 30.0 + 35.0 * exp(-day / 40.0) : 60.0);
+      double v = base + 3.0 * sin(i * 2 * M_PI / 24.0 + c) + (rand() % 11 - 5) / 10.0;
+      sample3Set(s, c, roundf((float)v * ((c == 2) ? 100.0f : 10.0f)) / ((c == 2) ? 100.0f : 10.0f));
+    }
+    if (rand() % 500 == 0) s.b1O2 = NAN;  // Capteur O2 absent de temps en temps
+  }
+  return out;
+}
+
+int main(int argc, char **argv) {
+  double years = (argc > 1) ? atof(argv[1]) : 10.0;
+  size_t n = (size_t)(years * 365 * 24);
+  std::vector<Sample3> series = makeSeries(n);
+
+  std::vector<uint8_t> archive;
+  archive.reserve(n * 16);
+  uint8_t block[TS_BLOCK_SIZE];
+  TsBlockEncoder enc;
+
+  auto t0 = std::chrono::steady_clock::now();
+  enc.begin(block);
+  for (const Sample3 &s : series) {
+    if (enc.append(s)) continue;
+    enc.seal();
+    archive.insert(archive.end(), block, block + TS_BLOCK_SIZE);
+    enc.begin(block);
+    enc.append(s);
+  }
+  enc.seal();
+  archive.insert(archive.end(), block, block + TS_BLOCK_SIZE);
+  auto t1 = std::chrono::steady_clock::now();
+
+  size_t decoded = 0, mismatches = 0;
+  Sample3 s;
+  for (size_t off = 0; off < archive.size(); off += TS_BLOCK_SIZE) {
+    TsBlockDecoder dec;
+    if (!dec.begin(&archive[off])) {
+      fprintf(stderr, "bloc %zu invalide\n", off / TS_BLOCK_SIZE);
+      return 1;
+    }
+    while (dec.next(s)) {
+      const Sample3 &ref = series[decoded++];
+      if (s.t != ref.t) mismatches++;
+      for (int c = 0; c < SAMPLE3_CHANNELS; c++) {
+        float a = sample3Get(s, c), b = sample3Get(ref, c);
+        if (isnan(a) != isnan(b) || (!isnan(a) && fabsf(a - b) > 0.006f)) mismatches++;
+      }
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  double encS = std::chrono::duration<double>(t1 - t0).count();
+  double decS = std::chrono::duration<double>(t2 - t1).count();
+  double bps = (double)archive.size() / n;
+  const double spiffsBytes = 1.3e6;  // Partition SPIFFS utile (4 MB, table par défaut)
+
+  printf("echantillons      : %zu (%.1f ans horaires)\n", n, years);
+  printf("archive           : %zu octets, %zu blocs\n", archive.size(), archive.size() / TS_BLOCK_SIZE);
+  printf("octets/echantillon: %.2f (Sample3 = %zu, ligne CSV ~ 62)\n", bps, sizeof(Sample3));
+  printf("annees / 1.3 MB   : %.1f\n", spiffsBytes / (bps * 24 * 365));
+  printf("encodage          : %.2f M ech/s\n", n / encS / 1e6);
+  printf("decodage          : %.2f M ech/s\n", decoded / decS / 1e6);
+  printf("aller-retour      : %s (%zu ecarts)\n", (decoded == n && mismatches == 0) ? "OK" : "ECHEC", mismatches);
+  return (decoded == n && mismatches == 0) ? 0 : 1;
+}
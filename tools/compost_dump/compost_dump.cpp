@@ -0,0 +1,164 @@
+// compost_dump : extraction et analyse des journaux à partir d'images flash (esptool read_flash).
+//
+//   g++ -O2 -std=c++17 -Iinclude -Itools/compost_dump tools/compost_dump/*.cpp
+//       src/csv_record.cpp src/ts_codec.cpp src/rollup.cpp src/epoch_table.cpp src/date_format.cpp
+//       -o compost_dump
+//
+// Exemples :
+//   ./compost_dump --list unite1.bin
+//   ./compost_dump --format csv -o unite1.csv unite1.bin
+//   ./compost_dump --source day --format json unite1.bin
+//   ./compost_dump --format stats terrain/*.bin
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "log_export.h"
+#include "spiffs_image.h"
+
+static void usage() {
+  fprintf(stderr,
+          "usage: compost_dump [options] image.bin [image2.bin ...]\n"
+          "  --list                  liste les fichiers de la partition\n"
+          "  --extract NOM           copie brute d'un fichier (ex. /data.csv)\n"
+          "  --source S              auto|csv|archive|hour|day (défaut auto)\n"
+          "  --format F              csv|json|stats (défaut csv)\n"
+          "  --from T / --to T       filtre epoch sur l'heure réelle (secondes)\n"
+          "  --offset N              début de la partition dans l'image (défaut : table à 0x8000)\n"
+          "  -o FICHIER              sortie (défaut stdout)\n");
+}
+
+static bool loadFile(const char *path, std::vector<uint8_t> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  out.resize(len > 0 ? (size_t)len : 0);
+  bool ok = fread(out.data(), 1, out.size(), f) == out.size();
+  fclose(f);
+  return ok;
+}
+
+static std::string unitName(const char *path) {
+  const char *base = strrchr(path, '/');
+  std::string name = base ? base + 1 : path;
+  size_t dot = name.rfind('.');
+  return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+int main(int argc, char **argv) {
+  ExportOptions opt;
+  std::string format = "csv", extract, outPath;
+  bool list = false;
+  long long offset = -1;
+  std::vector<const char *> images;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--list") list = true;
+    else if (a == "--extract" && hasValue) extract = argv[++i];
+    else if (a == "--format" && hasValue) format = argv[++i];
+    else if (a == "--from" && hasValue) opt.from = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (a == "--to" && hasValue) opt.to = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (a == "--offset" && hasValue) offset = strtoll(argv[++i], nullptr, 0);
+    else if (a == "-o" && hasValue) outPath = argv[++i];
+    else if (a == "--source" && hasValue) {
+      std::string s = argv[++i];
+      if (s == "auto") opt.source = SOURCE_AUTO;
+      else if (s == "csv") opt.source = SOURCE_CSV;
+      else if (s == "archive") opt.source = SOURCE_ARCHIVE;
+      else if (s == "hour") opt.source = SOURCE_HOUR;
+      else if (s == "day") opt.source = SOURCE_DAY;
+      else { usage(); return 2; }
+    }
+    else if (a[0] == '-') { usage(); return 2; }
+    else images.push_back(argv[i]);
+  }
+  if (images.empty() || (format != "csv" && format != "json" && format != "stats")) {
+    usage();
+    return 2;
+  }
+
+  FILE *out = outPath.empty() ? stdout : fopen(outPath.c_str(), "wb");
+  if (!out) {
+    perror(outPath.c_str());
+    return 1;
+  }
+
+  bool multi = images.size() > 1;
+  bool rollups = opt.source == SOURCE_HOUR || opt.source == SOURCE_DAY;
+  std::unique_ptr<SampleWriter> writer;
+  if (format == "csv") writer.reset(new CsvWriter(out, multi));
+  else if (format == "json") writer.reset(new JsonWriter(out, multi));
+  else writer.reset(new StatsWriter(out));
+  if (!list && extract.empty()) writer->begin(rollups);
+
+  int rc = 0;
+  std::vector<uint8_t> raw;
+  for (const char *path : images) {
+    if (!loadFile(path, raw)) {
+      perror(path);
+      rc = 1;
+      continue;
+    }
+
+    // Dump complet de la flash : localiser la partition via la table
+    size_t start = 0, size = raw.size();
+    bool littleFs = false;
+    if (offset >= 0) {
+      start = (size_t)offset < raw.size() ? (size_t)offset : raw.size();
+      size = raw.size() - start;
+    } else if (findSpiffsPartition(raw.data(), raw.size(), start, size, littleFs) && littleFs) {
+      fprintf(stderr, "%s : partition LittleFS non supportée (le firmware utilise SPIFFS)\n", path);
+      rc = 1;
+      continue;
+    }
+
+    SpiffsImage fs;
+    if (!fs.open(raw.data() + start, size)) {
+      fprintf(stderr, "%s : %s\n", path, fs.error.c_str());
+      rc = 1;
+      continue;
+    }
+
+    if (list) {
+      printf("%s :\n", path);
+      for (const SpiffsFile &f : fs.files()) printf("  %-32s %10u\n", f.name.c_str(), f.size);
+      continue;
+    }
+
+    if (!extract.empty()) {
+      const SpiffsFile *f = fs.find(extract);
+      std::string content;
+      if (!f) {
+        fprintf(stderr, "%s : %s absent\n", path, extract.c_str());
+        rc = 1;
+        continue;
+      }
+      if (!fs.read(*f, content)) fprintf(stderr, "%s : %s\n", path, fs.error.c_str());
+      fwrite(content.data(), 1, content.size(), out);
+      continue;
+    }
+
+    DecodeCounters c;
+    std::string err;
+    if (!exportImage(fs, unitName(path), opt, *writer, c, err)) {
+      fprintf(stderr, "%s : %s\n", path, err.c_str());
+      rc = 1;
+      continue;
+    }
+    fprintf(stderr, "%s : %zu valides, %zu sans CRC, %zu rejetes, %zu segments d'horloge\n", path, c.ok,
+            c.legacy, c.bad, c.clockSegments);
+  }
+
+  if (!list && extract.empty()) writer->end();
+  writer.reset();
+  if (out != stdout) fclose(out);
+  return rc;
+}
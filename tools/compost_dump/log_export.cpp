@@ -0,0 +1,388 @@
+#include "log_export.h"
+
+#include <math.h>
+#include <string.h>
+#include "csv_record.h"
+#include "archive_store.h"
+#include "rollup_store.h"
+
+static const char *CHANNEL_NAMES[SAMPLE3_CHANNELS] = {
+  "temperature_bac1", "humidity_bac1", "oxygen_bac1", "temperature_bac2",
+  "humidity_bac2", "temperature_bac3", "humidity_bac3"};
+
+// ===== Décodage =====
+size_t decodeCsvLog(const std::string &data, const SampleFn &cb, DecodeCounters &c) {
+  size_t n = 0;
+  size_t pos = 0;
+  Sample3 s;
+  while (pos < data.size()) {
+    const char *line = data.data() + pos;
+    const char *nl = (const char *)memchr(line, '\n', data.size() - pos);
+    if (!nl) {
+      c.bad++;  // Fragment final déchiré
+      break;
+    }
+    size_t len = nl - line;
+    pos += len + 1;
+    if (len == 0) continue;
+    switch (csvParseRecord(line, len, s)) {
+      case CSV_RECORD_OK: c.ok++; cb(s); n++; break;
+      case CSV_RECORD_LEGACY: c.legacy++; cb(s); n++; break;
+      case CSV_RECORD_HEADER: break;
+      case CSV_RECORD_BAD: c.bad++; break;
+    }
+  }
+  return n;
+}
+
+static size_t decodeBlock(const uint8_t *blk, const SampleFn &cb, DecodeCounters &c) {
+  TsBlockDecoder dec;
+  if (!dec.begin(blk)) {
+    c.bad++;
+    return 0;
+  }
+  size_t n = 0;
+  Sample3 s;
+  while (dec.next(s)) {
+    cb(s);
+    n++;
+  }
+  c.ok += n;
+  return n;
+}
+
+size_t decodeArchive(const std::string &sealed, const std::string &open, const SampleFn &cb,
+                     DecodeCounters &c) {
+  size_t n = 0;
+  for (size_t off = 0; off + TS_BLOCK_SIZE <= sealed.size(); off += TS_BLOCK_SIZE)
+    n += decodeBlock((const uint8_t *)sealed.data() + off, cb, c);
+  // Bloc ouvert : journal de lignes CSV, ou bloc binaire des anciennes images (magic "TS")
+  bool legacy = open.size() >= TS_BLOCK_HEADER && (uint8_t)open[0] == (TS_BLOCK_MAGIC & 0xFF) &&
+                (uint8_t)open[1] == (TS_BLOCK_MAGIC >> 8);
+  if (!legacy) {
+    n += decodeCsvLog(open, cb, c);
+  } else {
+    uint8_t blk[TS_BLOCK_SIZE] = {0};
+    memcpy(blk, open.data(), open.size() < TS_BLOCK_SIZE ? open.size() : TS_BLOCK_SIZE);
+    n += decodeBlock(blk, cb, c);
+  }
+  return n;
+}
+
+size_t decodeRollups(const std::string &data, const std::function<void(const RollupBucket &)> &cb,
+                     DecodeCounters &c) {
+  size_t n = 0;
+  RollupBucket b;
+  for (size_t off = 0; off + ROLLUP_RECORD_SIZE <= data.size(); off += ROLLUP_RECORD_SIZE) {
+    rollupDecode((const uint8_t *)data.data() + off, b);
+    cb(b);
+    n++;
+  }
+  c.ok += n;
+  if (data.size() % ROLLUP_RECORD_SIZE) c.bad++;
+  return n;
+}
+
+// ===== Export d'une image =====
+static bool readFile(const SpiffsImage &fs, const char *name, std::string &out, bool &found) {
+  const SpiffsFile *f = fs.find(name);
+  found = f != nullptr;
+  out.clear();
+  return !f || fs.read(*f, out);
+}
+
+bool readEpochTable(const SpiffsImage &fs, EpochTable &tab) {
+  std::string data;
+  bool found = false;
+  epochInit(tab);
+  if (!readFile(fs, EPOCH_FILE, data, found) || !found) return false;
+  return epochDecode((const uint8_t *)data.data(), data.size(), tab);
+}
+
+bool exportImage(const SpiffsImage &fs, const std::string &unit, const ExportOptions &opt,
+                 SampleWriter &w, DecodeCounters &c, std::string &err) {
+  std::string a, b;
+  bool found = false, foundOpen = false;
+  // Les journaux gardent le temps brut de l'horloge : heure réelle via la table de l'image
+  EpochTable epochs;
+  if (readEpochTable(fs, epochs)) c.clockSegments = epochs.count;
+  auto inRange = [&](uint32_t t) { return t >= opt.from && t <= opt.to; };
+  auto sample = [&](const Sample3 &raw) {
+    Sample3 s = raw;
+    s.t = (time_t)epochReal(epochs, (uint32_t)raw.t);
+    if (inRange((uint32_t)s.t)) w.add(unit, s);
+  };
+
+  if (opt.source == SOURCE_HOUR || opt.source == SOURCE_DAY) {
+    // Ancienne génération puis courante ; créneaux déjà en heure réelle
+    RollupTier tier = opt.source == SOURCE_HOUR ? ROLLUP_HOUR : ROLLUP_DAY;
+    if (!readFile(fs, ROLLUP_OLD_FILES[tier], b, foundOpen)) c.bad++;
+    if (!readFile(fs, ROLLUP_FILES[tier], a, found)) c.bad++;
+    if (!found && !foundOpen) {
+      err = std::string(ROLLUP_FILES[tier]) + " absent";
+      return false;
+    }
+    b.resize(b.size() - b.size() % ROLLUP_RECORD_SIZE);
+    decodeRollups(b + a, [&](const RollupBucket &r) {
+      if (inRange(r.start)) w.addRollup(unit, r);
+    }, c);
+    return true;
+  }
+
+  if (opt.source != SOURCE_CSV) {
+    if (!readFile(fs, ARCHIVE_FILE, a, found)) c.bad++;
+    if (!readFile(fs, ARCHIVE_OPEN_FILE, b, foundOpen)) c.bad++;
+    if (found || foundOpen) {
+      decodeArchive(a, b, sample, c);
+      return true;
+    }
+    if (opt.source == SOURCE_ARCHIVE) {
+      err = "archive absente";
+      return false;
+    }
+  }
+
+  if (!readFile(fs, CSV_LOG_FILE, a, found)) c.bad++;
+  if (!found) {
+    err = std::string(CSV_LOG_FILE) + " absent";
+    return false;
+  }
+  decodeCsvLog(a, sample, c);
+  return true;
+}
+
+// ===== Formatage =====
+void SampleWriter::flush() {
+  if (!buf.empty()) fwrite(buf.data(), 1, buf.size(), out);
+  buf.clear();
+}
+
+void SampleWriter::put(const char *s, size_t n) {
+  buf.append(s, n);
+}
+
+void SampleWriter::put(const char *s) {
+  buf.append(s);
+}
+
+void SampleWriter::putUint(uint32_t v) {
+  char tmp[10];
+  int n = 0;
+  do {
+    tmp[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n) buf.push_back(tmp[--n]);
+}
+
+void SampleWriter::putFixed2(float v, const char *nanText) {
+  if (!isfinite(v)) {
+    put(nanText);
+    return;
+  }
+  long c = lroundf(v * 100.0f);
+  if (c < 0) {
+    buf.push_back('-');
+    c = -c;
+  }
+  putUint((uint32_t)(c / 100));
+  char frac[3] = {'.', (char)('0' + (c / 10) % 10), (char)('0' + c % 10)};
+  put(frac, 3);
+}
+
+// Date civile depuis un nombre de jours (algorithme de H. Hinnant), mise en cache par jour
+void SampleWriter::putDateTime(uint32_t t) {
+  uint32_t day = t / 86400;
+  if (day != cachedDay) {
+    int32_t z = (int32_t)day + 719468;
+    int32_t era = z / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int32_t y = (int32_t)yoe + era * 400;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+    uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+    if (m <= 2) y++;
+    uint32_t yy = (uint32_t)y % 10000;
+    const char date[10] = {
+      (char)('0' + yy / 1000), (char)('0' + yy / 100 % 10), (char)('0' + yy / 10 % 10),
+      (char)('0' + yy % 10), '-', (char)('0' + m / 10), (char)('0' + m % 10), '-',
+      (char)('0' + d / 10), (char)('0' + d % 10)};
+    memcpy(cachedDate, date, sizeof(date));
+    cachedDay = day;
+  }
+  uint32_t sec = t % 86400;
+  char hms[9] = {
+    (char)('0' + sec / 36000), (char)('0' + sec / 3600 % 10), ':',
+    (char)('0' + sec % 3600 / 600), (char)('0' + sec % 3600 / 60 % 10), ':',
+    (char)('0' + sec % 60 / 10), (char)('0' + sec % 10), '\0'};
+  put(cachedDate, 10);
+  buf.push_back(' ');
+  put(hms, 8);
+}
+
+// ----- CSV -----
+void CsvWriter::begin(bool rollups) {
+  if (withUnit) put("unit,");
+  put(rollups ? "date_time,samples" : "date_time");
+  for (const char *name : CHANNEL_NAMES) {
+    if (!rollups) {
+      buf.push_back(',');
+      put(name);
+      continue;
+    }
+    for (const char *suffix : {"_mean", "_min", "_max"}) {
+      buf.push_back(',');
+      put(name);
+      put(suffix);
+    }
+  }
+  buf.push_back('\n');
+}
+
+void CsvWriter::add(const std::string &unit, const Sample3 &s) {
+  if (withUnit) {
+    put(unit.data(), unit.size());
+    buf.push_back(',');
+  }
+  putDateTime((uint32_t)s.t);
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    buf.push_back(',');
+    putFixed2(sample3Get(s, i), "NAN");
+  }
+  buf.push_back('\n');
+  maybeFlush();
+}
+
+void CsvWriter::addRollup(const std::string &unit, const RollupBucket &b) {
+  if (withUnit) {
+    put(unit.data(), unit.size());
+    buf.push_back(',');
+  }
+  putDateTime(b.start);
+  buf.push_back(',');
+  putUint(b.samples);
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    buf.push_back(',');
+    putFixed2(rollupMean(b.ch[i]), "NAN");
+    buf.push_back(',');
+    putFixed2(rollupMin(b.ch[i]), "NAN");
+    buf.push_back(',');
+    putFixed2(rollupMax(b.ch[i]), "NAN");
+  }
+  buf.push_back('\n');
+  maybeFlush();
+}
+
+// ----- JSON (même forme que /api/history) -----
+void JsonWriter::open(const std::string &unit, uint32_t t) {
+  if (!first) buf.push_back(',');
+  first = false;
+  put("{");
+  if (withUnit) {
+    put("\"unit\":\"");
+    put(unit.data(), unit.size());
+    put("\",");
+  }
+  put("\"t\":");
+  putUint(t);
+}
+
+void JsonWriter::add(const std::string &unit, const Sample3 &s) {
+  open(unit, (uint32_t)s.t);
+  put(",\"b1\":{\"tempC\":"); putFixed2(s.b1Temp, "null");
+  put(",\"humPct\":"); putFixed2(s.b1Hum, "null");
+  put(",\"o2Pct\":"); putFixed2(s.b1O2, "null");
+  put("},\"b2\":{\"tempC\":"); putFixed2(s.b2Temp, "null");
+  put(",\"humPct\":"); putFixed2(s.b2Hum, "null");
+  put("},\"b3\":{\"tempC\":"); putFixed2(s.b3Temp, "null");
+  put(",\"humPct\":"); putFixed2(s.b3Hum, "null");
+  put("}}");
+  maybeFlush();
+}
+
+void JsonWriter::addRollup(const std::string &unit, const RollupBucket &b) {
+  open(unit, b.start);
+  put(",\"n\":");
+  putUint(b.samples);
+  float (*vals[3])(const RollupChannel &) = {rollupMean, rollupMin, rollupMax};
+  const char *groups[3] = {"", "\"min\":{", "\"max\":{"};
+  for (int g = 0; g < 3; g++) {
+    put(",");
+    put(groups[g]);
+    put("\"b1\":{\"tempC\":"); putFixed2(vals[g](b.ch[0]), "null");
+    put(",\"humPct\":"); putFixed2(vals[g](b.ch[1]), "null");
+    put(",\"o2Pct\":"); putFixed2(vals[g](b.ch[2]), "null");
+    put("},\"b2\":{\"tempC\":"); putFixed2(vals[g](b.ch[3]), "null");
+    put(",\"humPct\":"); putFixed2(vals[g](b.ch[4]), "null");
+    put("},\"b3\":{\"tempC\":"); putFixed2(vals[g](b.ch[5]), "null");
+    put(",\"humPct\":"); putFixed2(vals[g](b.ch[6]), "null");
+    put(g ? "}}" : "}");
+  }
+  put("}");
+  maybeFlush();
+}
+
+// ----- Statistiques -----
+void StatsWriter::reset() {
+  samples = 0;
+  tFirst = tLast = 0;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    sum[i] = 0;
+    mn[i] = INFINITY;
+    mx[i] = -INFINITY;
+    count[i] = 0;
+  }
+}
+
+void StatsWriter::accumulate(const std::string &u, uint32_t t, const float *v) {
+  if (u != unit) {
+    if (samples) report();
+    unit = u;
+  }
+  if (samples == 0) tFirst = t;
+  tLast = t;
+  samples++;
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    if (!isfinite(v[i])) continue;
+    sum[i] += v[i];
+    if (v[i] < mn[i]) mn[i] = v[i];
+    if (v[i] > mx[i]) mx[i] = v[i];
+    count[i]++;
+  }
+}
+
+void StatsWriter::add(const std::string &u, const Sample3 &s) {
+  float v[SAMPLE3_CHANNELS];
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) v[i] = sample3Get(s, i);
+  accumulate(u, (uint32_t)s.t, v);
+}
+
+void StatsWriter::addRollup(const std::string &u, const RollupBucket &b) {
+  float v[SAMPLE3_CHANNELS];
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) v[i] = rollupMean(b.ch[i]);
+  accumulate(u, b.start, v);
+}
+
+void StatsWriter::report() {
+  char line[160];
+  snprintf(line, sizeof(line), "== %s : %zu points\n", unit.c_str(), samples);
+  put(line);
+  if (samples) {
+    put("   de ");
+    putDateTime(tFirst);
+    put(" a ");
+    putDateTime(tLast);
+    put(" (UTC)\n");
+  }
+  for (int i = 0; i < SAMPLE3_CHANNELS; i++) {
+    if (count[i])
+      snprintf(line, sizeof(line), "   %-18s n=%-8zu min=%8.2f max=%8.2f moy=%8.2f\n", CHANNEL_NAMES[i],
+               count[i], mn[i], mx[i], sum[i] / count[i]);
+    else
+      snprintf(line, sizeof(line), "   %-18s n=0\n", CHANNEL_NAMES[i]);
+    put(line);
+  }
+  reset();
+}
@@ -0,0 +1,119 @@
+#ifndef LOG_EXPORT_H
+#define LOG_EXPORT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include "web_app.h"
+#include "rollup.h"
+#include "epoch_table.h"
+#include "spiffs_image.h"
+
+// ===== Décodage des formats on-flash =====
+struct DecodeCounters {
+  size_t ok = 0;       // enregistrements valides
+  size_t legacy = 0;   // lignes CSV sans CRC
+  size_t bad = 0;      // lignes / blocs rejetés
+  size_t clockSegments = 0;  // segments d'horloge appliqués (EPOCH_FILE), 0 = temps bruts
+};
+
+typedef std::function<void(const Sample3 &)> SampleFn;
+
+size_t decodeCsvLog(const std::string &data, const SampleFn &cb, DecodeCounters &c);
+// open : journal du bloc ouvert (/archive.open)
+size_t decodeArchive(const std::string &sealed, const std::string &open, const SampleFn &cb,
+                     DecodeCounters &c);
+size_t decodeRollups(const std::string &data, const std::function<void(const RollupBucket &)> &cb,
+                     DecodeCounters &c);
+
+class SampleWriter;
+
+// ===== Export d'une image =====
+enum LogSource { SOURCE_AUTO, SOURCE_CSV, SOURCE_ARCHIVE, SOURCE_HOUR, SOURCE_DAY };
+
+struct ExportOptions {
+  LogSource source = SOURCE_AUTO;   // auto : archive si présente, sinon CSV
+  uint32_t from = 0;                // Filtre sur l'heure réelle
+  uint32_t to = 0xFFFFFFFF;
+};
+
+// Table des segments d'horloge de l'image (temps bruts -> heure réelle, epoch_table.h) ;
+// absente ou illisible : table vide, temps bruts inchangés
+bool readEpochTable(const SpiffsImage &fs, EpochTable &tab);
+
+bool exportImage(const SpiffsImage &fs, const std::string &unit, const ExportOptions &opt,
+                 SampleWriter &w, DecodeCounters &c, std::string &err);
+
+// ===== Sorties =====
+class SampleWriter {
+ public:
+  explicit SampleWriter(FILE *out) : out(out) { buf.reserve(BUF_SIZE + 512); }
+  virtual ~SampleWriter() { flush(); }
+  virtual void begin(bool rollups) { (void)rollups; }
+  virtual void add(const std::string &unit, const Sample3 &s) = 0;
+  virtual void addRollup(const std::string &unit, const RollupBucket &b) = 0;
+  virtual void end() {}
+  void flush();
+
+ protected:
+  static const size_t BUF_SIZE = 1 << 16;
+  FILE *out;
+  std::string buf;
+  void put(const char *s, size_t n);
+  void put(const char *s);
+  void putFixed2(float v, const char *nanText);  // 2 décimales, sans printf
+  void putDateTime(uint32_t t);                  // "YYYY-MM-DD HH:MM:SS" UTC
+  void putUint(uint32_t v);
+  void maybeFlush() { if (buf.size() >= BUF_SIZE) flush(); }
+
+ private:
+  uint32_t cachedDay = 0xFFFFFFFF;
+  char cachedDate[10];
+};
+
+class CsvWriter : public SampleWriter {
+ public:
+  CsvWriter(FILE *out, bool withUnit) : SampleWriter(out), withUnit(withUnit) {}
+  void begin(bool rollups) override;
+  void add(const std::string &unit, const Sample3 &s) override;
+  void addRollup(const std::string &unit, const RollupBucket &b) override;
+
+ private:
+  bool withUnit;
+};
+
+class JsonWriter : public SampleWriter {
+ public:
+  JsonWriter(FILE *out, bool withUnit) : SampleWriter(out), withUnit(withUnit) {}
+  void begin(bool) override { put("["); }
+  void add(const std::string &unit, const Sample3 &s) override;
+  void addRollup(const std::string &unit, const RollupBucket &b) override;
+  void end() override { put("]\n"); }
+
+ private:
+  bool withUnit;
+  bool first = true;
+  void open(const std::string &unit, uint32_t t);
+};
+
+// Statistiques par canal (count/min/max/moyenne), sur échantillons ou moyennes d'agrégats
+class StatsWriter : public SampleWriter {
+ public:
+  explicit StatsWriter(FILE *out) : SampleWriter(out) { reset(); }
+  void add(const std::string &unit, const Sample3 &s) override;
+  void addRollup(const std::string &unit, const RollupBucket &b) override;
+  void end() override { report(); }
+
+ private:
+  std::string unit;
+  size_t samples;
+  uint32_t tFirst, tLast;
+  double sum[SAMPLE3_CHANNELS], mn[SAMPLE3_CHANNELS], mx[SAMPLE3_CHANNELS];
+  size_t count[SAMPLE3_CHANNELS];
+  void reset();
+  void report();
+  void accumulate(const std::string &u, uint32_t t, const float *v);
+};
+
+#endif
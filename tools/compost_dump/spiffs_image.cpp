@@ -0,0 +1,253 @@
+#include "spiffs_image.h"
+
+#include <algorithm>
+#include <string.h>
+
+// Drapeaux d'en-tête de page (actifs à 0, la flash ne fait que passer des bits de 1 à 0)
+static const uint8_t PH_FLAG_USED = 1 << 0;
+static const uint8_t PH_FLAG_FINAL = 1 << 1;
+static const uint8_t PH_FLAG_INDEX = 1 << 2;
+static const uint8_t PH_FLAG_IXDELE = 1 << 6;
+static const uint8_t PH_FLAG_DELET = 1 << 7;
+static const uint16_t OBJ_ID_IX_FLAG = 0x8000;
+static const uint16_t OBJ_ID_FREE = 0xFFFF;
+static const uint8_t OBJ_TYPE_FILE = 1;
+
+static const uint32_t PAGE_HEADER = 5;     // obj_id u16, span_ix u16, flags u8
+static const uint32_t OBJ_IX_HEADER = 8;   // en-tête de page + alignement
+
+static uint16_t get16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = v >> 24;
+}
+
+static bool refLess(uint16_t aObj, uint16_t aSpan, uint16_t bObj, uint16_t bSpan) {
+  return aObj != bObj ? aObj < bObj : aSpan < bSpan;
+}
+
+// ===== Lecture =====
+uint32_t SpiffsImage::headerSize() const {
+  // spiffs_page_object_ix_header (packed) : en-tête 8 + size 4 + type 1 + nom + méta
+  return OBJ_IX_HEADER + 4 + 1 + cfg.nameLen + cfg.metaLen;
+}
+
+bool SpiffsImage::open(const uint8_t *data, size_t len, const SpiffsConfig &c) {
+  img = data;
+  imgLen = len;
+  cfg = c;
+  fileList.clear();
+  dataPages.clear();
+  indexPages.clear();
+
+  if (cfg.pageSize == 0 || cfg.blockSize % cfg.pageSize || len < cfg.blockSize) {
+    error = "image trop petite ou configuration invalide";
+    return false;
+  }
+  uint32_t pagesPerBlock = cfg.blockSize / cfg.pageSize;
+  luPages = std::max<uint32_t>(1, pagesPerBlock * 2 / cfg.pageSize);
+  uint32_t pageCount = (uint32_t)(len / cfg.blockSize) * pagesPerBlock;
+
+  for (uint32_t p = 0; p < pageCount; p++) {
+    if (p % pagesPerBlock < luPages) continue;  // Pages de table de correspondance
+    const uint8_t *ph = img + (size_t)p * cfg.pageSize;
+    uint16_t obj = get16(ph);
+    uint16_t span = get16(ph + 2);
+    uint8_t flags = ph[4];
+    if (obj == OBJ_ID_FREE || obj == 0) continue;
+    if (flags & (PH_FLAG_USED | PH_FLAG_FINAL)) continue;  // Libre ou écriture non finalisée
+    if (!(flags & PH_FLAG_DELET)) continue;                 // Supprimée
+
+    bool index = !(flags & PH_FLAG_INDEX);
+    PageRef ref = {(uint16_t)(obj & ~OBJ_ID_IX_FLAG), span, p, index};
+    if (!index) {
+      dataPages.push_back(ref);
+      continue;
+    }
+    indexPages.push_back(ref);
+    if (span != 0 || !(flags & PH_FLAG_IXDELE)) continue;
+
+    // En-tête d'objet : taille, type, nom
+    if (ph[12] != OBJ_TYPE_FILE) continue;
+    SpiffsFile f;
+    f.objId = ref.objId;
+    f.size = get32(ph + 8);
+    const char *name = (const char *)(ph + 13);
+    f.name.assign(name, strnlen(name, cfg.nameLen));
+    fileList.push_back(f);
+  }
+
+  auto cmp = [](const PageRef &a, const PageRef &b) { return refLess(a.objId, a.span, b.objId, b.span); };
+  std::sort(dataPages.begin(), dataPages.end(), cmp);
+  std::sort(indexPages.begin(), indexPages.end(), cmp);
+  std::sort(fileList.begin(), fileList.end(),
+            [](const SpiffsFile &a, const SpiffsFile &b) { return a.name < b.name; });
+  return true;
+}
+
+const SpiffsImage::PageRef *SpiffsImage::lookup(const std::vector<PageRef> &v, uint16_t obj,
+                                                uint16_t span) const {
+  auto it = std::lower_bound(v.begin(), v.end(), std::make_pair(obj, span),
+                             [](const PageRef &r, const std::pair<uint16_t, uint16_t> &k) {
+                               return refLess(r.objId, r.span, k.first, k.second);
+                             });
+  if (it == v.end() || it->objId != obj || it->span != span) return nullptr;
+  return &*it;
+}
+
+const SpiffsFile *SpiffsImage::find(const std::string &name) const {
+  for (const SpiffsFile &f : fileList)
+    if (f.name == name) return &f;
+  return nullptr;
+}
+
+bool SpiffsImage::read(const SpiffsFile &f, std::string &out) const {
+  uint32_t dataPerPage = cfg.pageSize - PAGE_HEADER;
+  uint32_t hdrEntries = (cfg.pageSize - headerSize()) / 2;
+  uint32_t ixEntries = (cfg.pageSize - OBJ_IX_HEADER) / 2;
+  uint32_t pageCount = (uint32_t)(imgLen / cfg.pageSize);
+
+  uint32_t size = f.size;
+  if (size == 0xFFFFFFFF) size = 0;  // Fichier créé mais jamais écrit
+  uint32_t spans = (size + dataPerPage - 1) / dataPerPage;
+
+  out.clear();
+  out.reserve(size);
+  bool complete = true;
+  for (uint32_t d = 0; d < spans; d++) {
+    // Page désignée par l'index de l'objet, sinon page de données trouvée au balayage
+    uint16_t ixSpan = (d < hdrEntries) ? 0 : (uint16_t)(1 + (d - hdrEntries) / ixEntries);
+    const PageRef *ix = lookup(indexPages, f.objId, ixSpan);
+    if (ix) {
+      uint32_t entry = (d < hdrEntries) ? d : (d - hdrEntries) % ixEntries;
+      uint32_t off = (ixSpan == 0 ? headerSize() : OBJ_IX_HEADER) + entry * 2;
+      uint16_t page = get16(img + (size_t)ix->page * cfg.pageSize + off);
+      if (page < pageCount) {
+        const uint8_t *ph = img + (size_t)page * cfg.pageSize;
+        uint8_t live = ph[4] & (PH_FLAG_USED | PH_FLAG_FINAL | PH_FLAG_INDEX | PH_FLAG_DELET);
+        if (get16(ph) == f.objId && get16(ph + 2) == d && live == (PH_FLAG_INDEX | PH_FLAG_DELET)) {
+          uint32_t take = std::min(dataPerPage, size - d * dataPerPage);
+          out.append((const char *)ph + PAGE_HEADER, take);
+          continue;
+        }
+      }
+    }
+    const PageRef *data = lookup(dataPages, f.objId, (uint16_t)d);
+    uint32_t take = std::min(dataPerPage, size - d * dataPerPage);
+    if (!data) {
+      out.append(take, '\0');
+      complete = false;
+      continue;
+    }
+    out.append((const char *)img + (size_t)data->page * cfg.pageSize + PAGE_HEADER, take);
+  }
+  if (!complete) error = f.name + " : pages de données manquantes";
+  return complete;
+}
+
+bool findSpiffsPartition(const uint8_t *data, size_t len, size_t &offset, size_t &size,
+                         bool &isLittleFs) {
+  static const size_t TABLE = 0x8000;
+  for (size_t e = TABLE; e + 32 <= len && e < TABLE + 0xC00; e += 32) {
+    const uint8_t *p = data + e;
+    if (p[0] != 0xAA || p[1] != 0x50) break;  // Fin de table (ou entrée MD5)
+    uint8_t type = p[2], subtype = p[3];
+    if (type != 0x01 || (subtype != 0x82 && subtype != 0x83)) continue;
+    offset = get32(p + 4);
+    size = get32(p + 8);
+    if (offset + size > len) return false;
+    // Arduino réutilise le sous-type "spiffs" pour LittleFS : vérifier le superbloc
+    isLittleFs = subtype == 0x83 || (size > 16 && memcmp(data + offset + 8, "littlefs", 8) == 0);
+    return true;
+  }
+  return false;
+}
+
+// ===== Construction =====
+SpiffsImageBuilder::SpiffsImageBuilder(size_t imageSize, const SpiffsConfig &c)
+    : cfg(c), img(imageSize - imageSize % c.blockSize, 0xFF) {}
+
+bool SpiffsImageBuilder::allocPage(uint32_t &page) {
+  uint32_t pagesPerBlock = cfg.blockSize / cfg.pageSize;
+  uint32_t luPages = std::max<uint32_t>(1, pagesPerBlock * 2 / cfg.pageSize);
+  while (nextPage % pagesPerBlock < luPages) nextPage++;
+  if ((size_t)(nextPage + 1) * cfg.pageSize > img.size() || nextPage > 0xFFFF) return false;
+  page = nextPage++;
+  return true;
+}
+
+void SpiffsImageBuilder::writePageHeader(uint32_t page, uint16_t objId, uint16_t span, bool index) {
+  uint32_t pagesPerBlock = cfg.blockSize / cfg.pageSize;
+  uint32_t luPages = std::max<uint32_t>(1, pagesPerBlock * 2 / cfg.pageSize);
+  uint16_t id = index ? (objId | OBJ_ID_IX_FLAG) : objId;
+
+  uint8_t *ph = &img[(size_t)page * cfg.pageSize];
+  put16(ph, id);
+  put16(ph + 2, span);
+  ph[4] = (uint8_t)~(PH_FLAG_USED | PH_FLAG_FINAL | (index ? PH_FLAG_INDEX : 0));
+
+  // Entrée de la table de correspondance du bloc
+  uint32_t block = page / pagesPerBlock;
+  uint32_t entry = page % pagesPerBlock - luPages;
+  put16(&img[(size_t)block * cfg.blockSize + entry * 2], id);
+}
+
+bool SpiffsImageBuilder::addFile(const std::string &name, const std::string &content) {
+  if (name.size() >= cfg.nameLen) return false;
+  uint16_t objId = nextObj++;
+  uint32_t dataPerPage = cfg.pageSize - PAGE_HEADER;
+  uint32_t hdrSize = OBJ_IX_HEADER + 4 + 1 + cfg.nameLen + cfg.metaLen;
+  uint32_t hdrEntries = (cfg.pageSize - hdrSize) / 2;
+  uint32_t ixEntries = (cfg.pageSize - OBJ_IX_HEADER) / 2;
+  uint32_t spans = (uint32_t)((content.size() + dataPerPage - 1) / dataPerPage);
+
+  uint32_t hdrPage;
+  if (!allocPage(hdrPage)) return false;
+  writePageHeader(hdrPage, objId, 0, true);
+  uint8_t *hp = &img[(size_t)hdrPage * cfg.pageSize];
+  put32(hp + 8, (uint32_t)content.size());
+  hp[12] = OBJ_TYPE_FILE;
+  memset(hp + 13, 0, cfg.nameLen);
+  memcpy(hp + 13, name.data(), name.size());
+
+  uint8_t *ixPage = hp;
+  uint32_t ixBase = hdrSize;
+  uint32_t ixCap = hdrEntries;
+  uint32_t ixUsed = 0;
+  uint16_t ixSpan = 0;
+  for (uint32_t d = 0; d < spans; d++) {
+    if (ixUsed == ixCap) {
+      uint32_t p;
+      if (!allocPage(p)) return false;
+      writePageHeader(p, objId, ++ixSpan, true);
+      ixPage = &img[(size_t)p * cfg.pageSize];
+      ixBase = OBJ_IX_HEADER;
+      ixCap = ixEntries;
+      ixUsed = 0;
+    }
+    uint32_t p;
+    if (!allocPage(p)) return false;
+    writePageHeader(p, objId, (uint16_t)d, false);
+    size_t off = (size_t)d * dataPerPage;
+    size_t take = std::min<size_t>(dataPerPage, content.size() - off);
+    memcpy(&img[(size_t)p * cfg.pageSize + PAGE_HEADER], content.data() + off, take);
+
+    put16(ixPage + ixBase + ixUsed * 2, (uint16_t)p);
+    ixUsed++;
+  }
+  return true;
+}
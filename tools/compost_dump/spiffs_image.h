@@ -0,0 +1,79 @@
+#ifndef SPIFFS_IMAGE_H
+#define SPIFFS_IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// ===== Lecture d'une image de partition SPIFFS (dump esptool) =====
+// Configuration ESP-IDF par défaut : page 256, bloc 4096, nom 32 octets, méta 4 octets.
+// Seules les pages finalisées et non supprimées sont prises en compte.
+
+struct SpiffsConfig {
+  uint32_t pageSize = 256;
+  uint32_t blockSize = 4096;
+  uint32_t nameLen = 32;
+  uint32_t metaLen = 4;
+};
+
+struct SpiffsFile {
+  std::string name;
+  uint32_t size;
+  uint16_t objId;
+};
+
+class SpiffsImage {
+ public:
+  // data/len : image brute de la partition (pas de copie, le buffer doit rester valide)
+  bool open(const uint8_t *data, size_t len, const SpiffsConfig &cfg = SpiffsConfig());
+
+  const std::vector<SpiffsFile> &files() const { return fileList; }
+  const SpiffsFile *find(const std::string &name) const;
+  bool read(const SpiffsFile &f, std::string &out) const;
+
+  mutable std::string error;
+
+ private:
+  struct PageRef {
+    uint16_t objId;   // sans le drapeau index
+    uint16_t span;
+    uint32_t page;
+    bool index;
+  };
+
+  const uint8_t *img = nullptr;
+  size_t imgLen = 0;
+  SpiffsConfig cfg;
+  uint32_t luPages = 1;
+  std::vector<SpiffsFile> fileList;
+  std::vector<PageRef> dataPages;   // triées (objId, span)
+  std::vector<PageRef> indexPages;  // triées (objId, span)
+
+  const PageRef *lookup(const std::vector<PageRef> &v, uint16_t obj, uint16_t span) const;
+  uint32_t headerSize() const;
+};
+
+// Cherche la partition SPIFFS dans un dump complet de la flash (table à 0x8000).
+// Retourne false si l'image ne contient pas de table (dump de partition seule).
+bool findSpiffsPartition(const uint8_t *data, size_t len, size_t &offset, size_t &size,
+                         bool &isLittleFs);
+
+// ===== Construction d'une image (benchmarks / essais) =====
+class SpiffsImageBuilder {
+ public:
+  explicit SpiffsImageBuilder(size_t imageSize, const SpiffsConfig &cfg = SpiffsConfig());
+  bool addFile(const std::string &name, const std::string &content);
+  const std::vector<uint8_t> &image() const { return img; }
+
+ private:
+  SpiffsConfig cfg;
+  std::vector<uint8_t> img;
+  uint32_t nextPage = 0;
+  uint16_t nextObj = 1;
+
+  bool allocPage(uint32_t &page);
+  void writePageHeader(uint32_t page, uint16_t objId, uint16_t span, bool index);
+};
+
+#endif
@@ -0,0 +1,103 @@
+# Génère include/web_assets_gz.h à partir de la page de include/web_page.h :
+# HTML, CSS et JS séparés, compressés gzip, avec une empreinte de contenu (ETag / version).
+#
+# Exécuté avant chaque compilation par PlatformIO (extra_scripts = pre:tools/gzip_assets.py),
+# ou à la main : python3 tools/gzip_assets.py
+#
+# Le fichier généré n'est réécrit que si son contenu change (pas de recompilation inutile).
+# Sans lui, le firmware sert la page non compressée (voir include/web_assets.h).
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 (fourni par PlatformIO / SCons)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE = os.path.join(PROJECT_DIR, "include", "web_page.h")
+OUTPUT = os.path.join(PROJECT_DIR, "include", "web_assets_gz.h")
+
+
+def digest(data):
+    return hashlib.sha256(data).hexdigest()[:12]
+
+
+def extract(pattern, text, what):
+    m = re.search(pattern, text, re.S)
+    if not m:
+        raise SystemExit("gzip_assets: %s introuvable dans %s" % (what, SOURCE))
+    return m
+
+
+def split_page(page):
+    css = extract(r"\n?[ \t]*<style>\n(.*?)[ \t]*</style>", page, "<style>")
+    js = extract(r"<script>\n(.*?)</script>", page, "<script>")
+    css_text, js_text = css.group(1), js.group(1)
+    css_hash, js_hash = digest(css_text.encode()), digest(js_text.encode())
+
+    # Ressources versionnées : l'URL change avec le contenu, le cache navigateur peut être permanent
+    html = page[:js.start()] + '<script src="/app.js?v=%s"></script>' % js_hash + page[js.end():]
+    html = (html[:css.start()] + '\n  <link rel="stylesheet" href="/app.css?v=%s" />' % css_hash
+            + html[css.end():])
+    return [
+        ("INDEX_HTML", "/", "text/html", html, False),
+        ("APP_CSS", "/app.css", "text/css", css_text, True),
+        ("APP_JS", "/app.js", "application/javascript", js_text, True),
+    ]
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 20):
+        lines.append("  " + ",".join("0x%02x" % b for b in data[i:i + 20]) + ",")
+    return "\n".join(lines)
+
+
+def generate():
+    with open(SOURCE, encoding="utf-8") as f:
+        source = f.read()
+    page = extract(r'R"HTML\((.*)\)HTML"', source, "INDEX_HTML").group(1)
+
+    out = [
+        "// Généré par tools/gzip_assets.py à partir de include/web_page.h : ne pas modifier.",
+        "#ifndef WEB_ASSETS_GZ_H",
+        "#define WEB_ASSETS_GZ_H",
+        "",
+    ]
+    table = []
+    total_raw = total_gz = 0
+    for name, path, ctype, text, versioned in split_page(page):
+        raw = text.encode("utf-8")
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+        total_raw += len(raw)
+        total_gz += len(gz)
+        out.append("// %s : %d octets, %d compressés" % (path, len(raw), len(gz)))
+        out.append("static const uint8_t %s_GZ[] PROGMEM = {" % name)
+        out.append(c_array(gz))
+        out.append("};")
+        out.append("")
+        table.append('  {"%s", "%s", %s_GZ, sizeof(%s_GZ), "\\"%s\\"", "%s"},'
+                     % (path, ctype, name, name, digest(raw), digest(raw) if versioned else ""))
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    out.extend(table)
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    out.append("")
+    text = "\n".join(out)
+
+    old = None
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, encoding="utf-8") as f:
+            old = f.read()
+    if old != text:
+        with open(OUTPUT, "w", encoding="utf-8") as f:
+            f.write(text)
+    print("gzip_assets: %d -> %d octets (%s)" % (total_raw, total_gz, os.path.relpath(OUTPUT, PROJECT_DIR)))
+
+
+generate()